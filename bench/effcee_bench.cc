@@ -0,0 +1,270 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "effcee/check.h"
+#include "effcee/cursor.h"
+#include "effcee/effcee.h"
+
+// Microbenchmarks for Effcee.  Each benchmark is parameterized by the size
+// of a synthetic input or check list, so that changes in performance show
+// up as numbers.  Run with --benchmark_filter=REGEX to select benchmarks.
+
+namespace {
+
+using effcee::Check;
+using effcee::CheckList;
+using effcee::Cursor;
+using effcee::Options;
+using effcee::StringPiece;
+using effcee::VarMapping;
+
+// A match case: an input and the check rules to match against it.
+struct Case {
+  std::string input;
+  std::string checks;
+};
+
+// Returns a log of |n| lines, of which only every 100th line is checked.
+Case SparseLog(int64_t n) {
+  Case c;
+  for (int64_t i = 0; i < n; ++i) {
+    if (i % 100 == 0) {
+      c.input += "event " + std::to_string(i) + " done\n";
+      c.checks += "CHECK: event " + std::to_string(i) + " done\n";
+    } else {
+      c.input += "noise: the quick brown fox " + std::to_string(i) + "\n";
+    }
+  }
+  return c;
+}
+
+// Returns |n| lines, each checked by a CHECK-NEXT rule after the first.
+Case NextChain(int64_t n) {
+  Case c;
+  for (int64_t i = 0; i < n; ++i) {
+    const std::string line = "%" + std::to_string(i) + " = OpIAdd %int %a %b";
+    c.input += line + "\n";
+    c.checks += (i == 0 ? "CHECK: " : "CHECK-NEXT: ") + line + "\n";
+  }
+  return c;
+}
+
+// Returns |n| lines matched by one group of |n| CHECK-DAG rules, listed in
+// the reverse order of the input.
+Case DagGroup(int64_t n) {
+  Case c;
+  for (int64_t i = 0; i < n; ++i) {
+    c.input += "OpDecorate %" + std::to_string(i) + " Location 0\n";
+  }
+  for (int64_t i = n - 1; i >= 0; --i) {
+    c.checks += "CHECK-DAG: OpDecorate %" + std::to_string(i) +
+                " {{[A-Za-z]+}} 0\n";
+  }
+  c.checks += "CHECK-NOT: OpDecorate\n";
+  return c;
+}
+
+// Returns 1000 lines between two positive checks, with |n| CHECK-NOT rules
+// between them, none of which match.
+Case ManyNots(int64_t n) {
+  Case c;
+  c.input = "begin\n";
+  for (int i = 0; i < 1000; ++i) {
+    c.input += "OpLoad %float %" + std::to_string(i) + "\n";
+  }
+  c.input += "end\n";
+  c.checks = "CHECK: begin\n";
+  for (int64_t i = 0; i < n; ++i) {
+    c.checks += "CHECK-NOT: OpStore %" + std::to_string(i) + "\n";
+  }
+  c.checks += "CHECK: end\n";
+  return c;
+}
+
+// Returns |n| definitions of IDs, each captured in a variable, followed by
+// |n| uses of them.
+Case Variables(int64_t n) {
+  Case c;
+  for (int64_t i = 0; i < n; ++i) {
+    const std::string num = std::to_string(i);
+    c.input += "%id" + num + " = OpConstant %int " + num + "\n";
+    c.checks += "CHECK: [[ID" + num + ":%\\w+]] = OpConstant %int " + num +
+                "\n";
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    const std::string num = std::to_string(i);
+    c.input += "OpStore %ptr %id" + num + "\n";
+    c.checks += "CHECK: OpStore %ptr [[ID" + num + "]]\n";
+  }
+  return c;
+}
+
+// Returns a single line of |n| bytes, with the checked text at its end.
+Case LongLine(int64_t n) {
+  Case c;
+  c.input.assign(size_t(n), 'x');
+  c.input += " needle 42\n";
+  c.checks = "CHECK: needle {{[0-9]+}}\n";
+  return c;
+}
+
+// Sets the bytes processed by |state| to those of |text| per iteration.
+void SetBytes(benchmark::State& state, const std::string& text) {
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(text.size()));
+}
+
+// Parsing
+
+void BM_ParseChecks(benchmark::State& state) {
+  const Case c = NextChain(state.range(0));
+  for (auto _ : state) {
+    auto parsed = effcee::ParseChecks(c.checks, Options());
+    benchmark::DoNotOptimize(parsed);
+  }
+  SetBytes(state, c.checks);
+}
+BENCHMARK(BM_ParseChecks)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+void BM_ParseChecksWithVariables(benchmark::State& state) {
+  const Case c = Variables(state.range(0));
+  for (auto _ : state) {
+    auto parsed = effcee::ParseChecks(c.checks, Options());
+    benchmark::DoNotOptimize(parsed);
+  }
+  SetBytes(state, c.checks);
+}
+BENCHMARK(BM_ParseChecksWithVariables)->RangeMultiplier(8)->Range(8, 1 << 12);
+
+// Check::Matches, against a line of the given length with the match at its
+// end.
+
+void BM_CheckMatchesLiteral(benchmark::State& state) {
+  const std::string line = std::string(size_t(state.range(0)), 'x') + "end";
+  const Check check(Check::Type::Simple, "end");
+  VarMapping vars;
+  for (auto _ : state) {
+    StringPiece input(line);
+    StringPiece captured;
+    benchmark::DoNotOptimize(check.Matches(&input, &captured, &vars));
+  }
+  SetBytes(state, line);
+}
+BENCHMARK(BM_CheckMatchesLiteral)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+void BM_CheckMatchesRegex(benchmark::State& state) {
+  const std::string line =
+      std::string(size_t(state.range(0)), 'x') + "%id = OpLoad %float %ptr";
+  auto parsed =
+      effcee::ParseChecks("CHECK: OpLoad {{%\\w+}} [[P:%\\w+]]", Options());
+  const Check& check = parsed.second[0];
+  VarMapping vars;
+  for (auto _ : state) {
+    StringPiece input(line);
+    StringPiece captured;
+    benchmark::DoNotOptimize(check.Matches(&input, &captured, &vars));
+  }
+  SetBytes(state, line);
+}
+BENCHMARK(BM_CheckMatchesRegex)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+void BM_CheckMatchesVariableUse(benchmark::State& state) {
+  const std::string line =
+      std::string(size_t(state.range(0)), 'x') + "OpStore %ptr %value";
+  auto parsed = effcee::ParseChecks(
+      "CHECK: [[V:%\\w+]] = \nCHECK: OpStore %ptr [[V]]", Options());
+  const Check& check = parsed.second[1];
+  VarMapping vars;
+  vars.Set(parsed.second[1].parts()[1].VarSlot(), "%value");
+  for (auto _ : state) {
+    StringPiece input(line);
+    StringPiece captured;
+    benchmark::DoNotOptimize(check.Matches(&input, &captured, &vars));
+  }
+  SetBytes(state, line);
+}
+BENCHMARK(BM_CheckMatchesVariableUse)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Cursor and diagnostics
+
+void BM_CursorLines(benchmark::State& state) {
+  const Case c = SparseLog(state.range(0));
+  for (auto _ : state) {
+    Cursor cursor(c.input);
+    size_t total = 0;
+    while (!cursor.Exhausted()) {
+      total += cursor.RestOfLine().size();
+      cursor.AdvanceLine();
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  SetBytes(state, c.input);
+}
+BENCHMARK(BM_CursorLines)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+void BM_LineMessage(benchmark::State& state) {
+  const Case c = SparseLog(state.range(0));
+  // Point at the start of the last line.
+  const StringPiece input(c.input);
+  const size_t last_line = input.substr(0, input.size() - 1).rfind('\n') + 1;
+  const StringPiece where = input.substr(last_line, 5);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        effcee::LineMessage(input, where, "note: scanning from here"));
+  }
+  SetBytes(state, c.input);
+}
+BENCHMARK(BM_LineMessage)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+// End-to-end matches, including parsing the check rules.
+
+// Benchmarks effcee::Match over the case made by |make_case| for the size
+// in |state|.  The match is expected to pass.
+void MatchCase(benchmark::State& state, Case (*make_case)(int64_t)) {
+  const Case c = make_case(state.range(0));
+  if (!effcee::Match(c.input, c.checks)) {
+    state.SkipWithError("match failed");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(effcee::Match(c.input, c.checks));
+  }
+  SetBytes(state, c.input);
+}
+
+void BM_MatchSparseLog(benchmark::State& state) { MatchCase(state, SparseLog); }
+BENCHMARK(BM_MatchSparseLog)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+void BM_MatchNextChain(benchmark::State& state) { MatchCase(state, NextChain); }
+BENCHMARK(BM_MatchNextChain)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+void BM_MatchDagGroup(benchmark::State& state) { MatchCase(state, DagGroup); }
+BENCHMARK(BM_MatchDagGroup)->RangeMultiplier(4)->Range(4, 1 << 10);
+
+void BM_MatchManyNots(benchmark::State& state) { MatchCase(state, ManyNots); }
+BENCHMARK(BM_MatchManyNots)->RangeMultiplier(4)->Range(4, 1 << 10);
+
+void BM_MatchVariables(benchmark::State& state) { MatchCase(state, Variables); }
+BENCHMARK(BM_MatchVariables)->RangeMultiplier(4)->Range(4, 1 << 12);
+
+void BM_MatchLongLine(benchmark::State& state) { MatchCase(state, LongLine); }
+BENCHMARK(BM_MatchLongLine)->RangeMultiplier(8)->Range(64, 1 << 21);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -17,13 +17,14 @@
 #include <algorithm>
 #include <cassert>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <utility>
 
 #include "cursor.h"
 #include "effcee.h"
 #include "make_unique.h"
+#include "search.h"
+#include "stats.h"
 #include "to_string.h"
 
 using Status = effcee::Result::Status;
@@ -52,6 +53,17 @@ Type TypeForSuffix(StringPiece suffix) {
   assert(pair_iter != type_str_table.end());
   return pair_iter->second;
 }
+
+// Returns true if the regex ".*" matches all of |text|.  That is, |text| has
+// no newline, and is valid UTF-8 to the satisfaction of RE2.  Only text
+// that is not ASCII needs a regex, which is counted in |stats| if it is not
+// null.
+bool DotStarSpans(StringPiece text, effcee::MatchStats* stats) {
+  if (effcee::IsAscii(text)) return text.find('\n') == StringPiece::npos;
+  if (stats) ++stats->regex_matches;
+  static const RE2 dot_star("[^\\n]*");
+  return RE2::FullMatch(text, dot_star);
+}
 }  // namespace
 
 namespace effcee {
@@ -62,13 +74,130 @@ int Check::Part::CountCapturingGroups() {
   return 0;
 }
 
-Check::Check(Type type, StringPiece param) : type_(type), param_(param) {
-  parts_.push_back(effcee::make_unique<Check::Part>(Part::Type::Fixed, param));
+Check::Check(Type type, StringPiece param)
+    : type_(type),
+      param_(param),
+      line_num_(0),
+      column_(0),
+      is_literal_(false),
+      num_captures_(0),
+      regex_max_mem_(0),
+      probed_regex_(false),
+      regex_too_large_(false),
+      line_searchable_(false) {
+  parts_.emplace_back(Part::Type::Fixed, param);
+  Compile();
+}
+
+Check::Check(Type type, StringPiece param, Parts&& parts,
+             int64_t regex_max_mem)
+    : type_(type),
+      param_(param),
+      line_num_(0),
+      column_(0),
+      parts_(std::move(parts)),
+      is_literal_(false),
+      num_captures_(0),
+      regex_max_mem_(regex_max_mem),
+      probed_regex_(false),
+      regex_too_large_(false),
+      line_searchable_(false) {
+  Compile();
+}
+
+void Check::Compile() {
+  num_captures_ = 2;  // The outer capture, and the constructed capture.
+  var_def_captures_.clear();
+  required_literals_.clear();
+  bool uses_vars = false;
+  // Regex parts are pasted unbracketed into the consume regex.  So an
+  // alternation, a flag setting such as (?i), or a \Q quote can change how
+  // the neighbouring fixed parts match.  Then don't require any literals.
+  bool fixed_parts_are_exact = true;
+  line_searchable_ = true;
+  for (auto& part : parts_) {
+    if (part.type() == Part::Type::Fixed) {
+      required_literals_.push_back(part.param());
+    } else if (part.type() == Part::Type::Regex) {
+      const auto regex = part.param();
+      if (regex.find('|') != StringPiece::npos ||
+          regex.find("(?") != StringPiece::npos ||
+          regex.find("\\Q") != StringPiece::npos) {
+        fixed_parts_are_exact = false;
+      }
+    }
+    if (part.type() == Part::Type::Regex || part.type() == Part::Type::VarDef) {
+      // These assertions can hold at a place in a single line, but not at
+      // the same place in a text of many lines.
+      const std::string regex = part.Regex(VarMapping());
+      if (regex.find_first_of("^$") != std::string::npos ||
+          regex.find("\\A") != std::string::npos ||
+          regex.find("\\z") != std::string::npos ||
+          regex.find("\\B") != std::string::npos) {
+        line_searchable_ = false;
+      }
+    }
+    const auto var_def_name = part.VarDefName();
+    if (!var_def_name.empty()) {
+      var_def_captures_.push_back(
+          {num_captures_++, part.VarSlot(), var_def_name});
+    }
+    num_captures_ += part.NumCapturingGroups();
+    uses_vars = uses_vars || !part.VarUseName().empty();
+  }
+  if (!fixed_parts_are_exact) required_literals_.clear();
+  // A pattern that is not valid UTF-8 can't be compiled by RE2, and then never
+  // matches.  So only use substring search for an ASCII string.
+  is_literal_ = parts_.size() == 1 &&
+                parts_[0].type() == Part::Type::Fixed &&
+                IsAscii(parts_[0].param());
+  if (!is_literal_ && !parts_.empty() && !uses_vars) {
+    regex_ = effcee::make_unique<const RE2>(ConsumeRegex(VarMapping()),
+                                            RegexOptions());
+    regex_too_large_ = regex_->error_code() == RE2::ErrorPatternTooLarge;
+  } else if (uses_vars && regex_max_mem_ > 0) {
+    // The regex is built when matching.  Check the part that does not
+    // depend on variable values now.
+    const RE2 probe(ConsumeRegex(VarMapping()), RegexOptions());
+    probed_regex_ = true;
+    regex_too_large_ = probe.error_code() == RE2::ErrorPatternTooLarge;
+  }
+  // A NOT check is searched for over the lines between two positive
+  // matches.  Without a literal to look for, that needs a regex.
+  if (type_ == Type::Not && regex_ && required_literals_.empty() &&
+      line_searchable_) {
+    search_regex_ = effcee::make_unique<const RE2>(SearchRegex(VarMapping()),
+                                                   RegexOptions());
+  }
+}
+
+RE2::Options Check::RegexOptions() const {
+  RE2::Options options;
+  if (regex_max_mem_ > 0) options.set_max_mem(regex_max_mem_);
+  return options;
+}
+
+std::string Check::ConsumeRegex(const VarMapping& vars) const {
+  // Anchoring is done by the caller.  Match any minimal prefix so we can
+  // easily skip over it without having to re-match the text.
+  std::string consume_regex(".*?(");
+  for (auto& part : parts_) {
+    consume_regex += part.Regex(vars);
+  }
+  consume_regex += ")";  // Finish the constructed grouping.
+  return consume_regex;
+}
+
+std::string Check::SearchRegex(const VarMapping& vars) const {
+  std::string search_regex;
+  for (auto& part : parts_) {
+    search_regex += part.Regex(vars);
+  }
+  return search_regex;
 }
 
 bool Check::Part::MightMatch(const VarMapping& vars) const {
-  return type_ != Type::VarUse ||
-         vars.find(ToString(VarUseName())) != vars.end();
+  return type_ != Type::VarUse || vars.IsSet(slot_);
 }
 
 std::string Check::Part::Regex(const VarMapping& vars) const {
@@ -80,10 +209,9 @@ std::string Check::Part::Regex(const VarMapping& vars) const {
     case Type::VarDef:
       return std::string("(") + ToString(expression_) + ")";
     case Type::VarUse: {
-      auto where = vars.find(ToString(VarUseName()));
-      if (where != vars.end()) {
+      if (vars.IsSet(slot_)) {
         // Return the escaped form of the current value of the variable.
-        return RE2::QuoteMeta((*where).second);
+        return vars.GetQuoted(slot_);
       } else {
         // The variable is not yet set.  Should not get here.
         return "";
@@ -93,55 +221,134 @@ std::string Check::Part::Regex(const VarMapping& vars) const {
   return "";  // Unreachable.  But we need to satisfy GCC.
 }
 
+bool Check::MatchesLiteral(StringPiece* input, StringPiece* captured,
+                           MatchStats* stats) const {
+  const StringPiece literal = parts_[0].param();
+  const size_t pos = FindLiteral(*input, literal);
+  if (pos == StringPiece::npos) return false;
+  // The regex form of this check skips a prefix with ".*?", which does not
+  // match newlines or invalid UTF-8.
+  if (!DotStarSpans(input->substr(0, pos), stats)) return false;
+  *captured = input->substr(pos, literal.size());
+  input->remove_prefix(pos + literal.size());
+  return true;
+}
+
+size_t Check::NumRegexesCompiled() const {
+  // Each regex and variable definition part compiles its expression to count
+  // its capturing groups.
+  size_t count = (regex_ || probed_regex_ ? 1 : 0) + (search_regex_ ? 1 : 0);
+  for (const auto& part : parts_) {
+    if (part.type() == Part::Type::Regex || part.type() == Part::Type::VarDef)
+      ++count;
+  }
+  return count;
+}
+
+bool Check::HasRequiredLiterals(StringPiece str) const {
+  for (const auto& literal : required_literals_) {
+    const size_t pos = FindLiteral(str, literal);
+    if (pos == StringPiece::npos) return false;
+    str.remove_prefix(pos + literal.size());
+  }
+  return true;
+}
+
 bool Check::Matches(StringPiece* input, StringPiece* captured,
-                    VarMapping* vars) const {
+                    VarMapping* vars, VarCaptures* var_captures,
+                    MatchStats* stats) const {
+  if (var_captures) var_captures->clear();
+  if (is_literal_) return MatchesLiteral(input, captured, stats);
   if (parts_.empty()) return false;
+  // Most attempts fail.  Reject cheaply when a required string is absent.
+  if (!HasRequiredLiterals(*input)) return false;
   for (auto& part : parts_) {
-    if (!part->MightMatch(*vars)) return false;
+    if (!part.MightMatch(*vars)) return false;
   }
 
-  std::unordered_map<int, std::string> var_def_indices;
-
-  // Construct a regex for the check patterns.  Anchor to the start
-  // of the input string, but also match any prefix. Do this so we
-  // can easily skip over any prefix without having to re-match the
-  // text.
-  std::ostringstream consume_regex;
-  // Match any minimal prefix, then start a constructed grouping for the
-  // pattern of interest.
-  consume_regex << ".*?(";
-  int num_captures = 2;  // The outer capture, and the constructed capture.
-  for (auto& part : parts_) {
-    consume_regex << part->Regex(*vars);
-    const auto var_def_name = part->VarDefName();
-    if (!var_def_name.empty()) {
-      var_def_indices[num_captures++] = ToString(var_def_name);
-    }
-    num_captures += part->NumCapturingGroups();
+  // Use the compiled regex if there is one.  Otherwise the regex depends on
+  // the current values of variables, so build it now.
+  std::unique_ptr<RE2> fresh_regex;
+  const RE2* regex = regex_.get();
+  if (!regex) {
+    fresh_regex = effcee::make_unique<RE2>(ConsumeRegex(*vars), RegexOptions());
+    regex = fresh_regex.get();
+    if (stats) ++stats->regexes_compiled;
   }
-  consume_regex << ")";  // Finish the constructed grouping.
-  std::unique_ptr<StringPiece[]> captures(new StringPiece[num_captures]);
-  const bool matched = RE2(consume_regex.str())
-                           .Match(*input, 0, input->size(), RE2::ANCHOR_START,
-                                  captures.get(), num_captures);
+
+  // Anchor to the start of the input string.  The regex matches any
+  // prefix before the pattern of interest.
+  // Most checks have few captures, so avoid allocating for them.
+  StringPiece small_captures[8];
+  std::unique_ptr<StringPiece[]> large_captures;
+  StringPiece* captures = small_captures;
+  if (num_captures_ > 8) {
+    large_captures.reset(new StringPiece[num_captures_]);
+    captures = large_captures.get();
+  }
+  const bool matched = regex->Match(*input, 0, input->size(),
+                                    RE2::ANCHOR_START, captures, num_captures_);
+  if (stats) ++stats->regex_matches;
   if (matched) {
+    if (stats) stats->var_definitions += var_def_captures_.size();
     *captured = captures[1];
     input->remove_prefix(captures[0].size());
     // Update the variable mapping.
-    for (auto& var_def_index : var_def_indices) {
-      const int index = var_def_index.first;
-      (*vars)[var_def_index.second] = ToString(captures[index]);
+    for (const auto& var_def_capture : var_def_captures_) {
+      const StringPiece value = captures[var_def_capture.index];
+      vars->Set(var_def_capture.slot, value);
+      if (var_captures) var_captures->emplace_back(var_def_capture.name, value);
     }
   }
 
   return matched;
 }
 
+size_t Check::Search(StringPiece text, const VarMapping& vars,
+                     MatchStats* stats) const {
+  if (is_literal_) return FindLiteral(text, parts_[0].param());
+  if (parts_.empty()) return StringPiece::npos;
+  for (auto& part : parts_) {
+    if (!part.MightMatch(vars)) return StringPiece::npos;
+  }
+  // A match on a line contains the first required literal.
+  if (!required_literals_.empty()) {
+    return FindLiteral(text, required_literals_[0]);
+  }
+  // Any line might match.
+  if (!line_searchable_) return 0;
+
+  // A match on a line is also a match in the whole text.  So the leftmost
+  // match in the whole text starts no later, though it may span lines.
+  std::unique_ptr<RE2> fresh_regex;
+  const RE2* regex = search_regex_.get();
+  if (!regex) {
+    fresh_regex = effcee::make_unique<RE2>(SearchRegex(vars), RegexOptions());
+    regex = fresh_regex.get();
+    if (stats) ++stats->regexes_compiled;
+  }
+  StringPiece match;
+  if (stats) ++stats->regex_matches;
+  if (!regex->Match(text, 0, text.size(), RE2::UNANCHORED, &match, 1)) {
+    return StringPiece::npos;
+  }
+  return size_t(match.data() - text.data());
+}
+
 namespace {
+// Returns the slot of the variable |name|, assigning the next free slot if
+// the name is new.
+int SlotFor(StringPiece name, effcee::VarSlots* slots) {
+  const int next = int(slots->size());
+  return slots->emplace(ToString(name), next).first->second;
+}
+
 // Returns a Result and a parts list for the given pattern.  This splits out
 // regular expressions as delimited by {{ and }}, and also variable uses and
-// definitions.  This can fail when a regular expression is invalid.
-std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern) {
+// definitions, whose variables are given slots from |slots|.  This can fail
+// when a regular expression is invalid.
+std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern,
+                                                effcee::VarSlots* slots) {
   Check::Parts parts;
   StringPiece fixed, regex, var;
 
@@ -157,20 +364,17 @@ std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern) {
     const bool var_exists = var_start < var_end && var_end < StringPiece::npos;
 
     if (regex_exists && (!var_exists || regex_start < var_start)) {
-      const auto consumed =
-          RE2::Consume(&pattern, "(.*?){{(.*?)}}", &fixed, &regex);
-      if (!consumed) {
-        assert(consumed &&
-               "Did not make forward progress for regex in check rule");
-      }
+      // Split off the text before the first "{{", and the regex between it
+      // and the first "}}", which must follow it.
+      fixed = pattern.substr(0, regex_start);
+      regex = pattern.substr(regex_start + 2, regex_end - regex_start - 2);
+      pattern.remove_prefix(regex_end + 2);
       if (!fixed.empty()) {
-        parts.emplace_back(
-            effcee::make_unique<Check::Part>(Type::Fixed, fixed));
+        parts.emplace_back(Type::Fixed, fixed);
       }
       if (!regex.empty()) {
-        parts.emplace_back(
-            effcee::make_unique<Check::Part>(Type::Regex, regex));
-        if (parts.back()->NumCapturingGroups() < 0) {
+        parts.emplace_back(Type::Regex, regex);
+        if (parts.back().NumCapturingGroups() < 0) {
           return std::make_pair(
               Result(Result::Status::BadRule,
                      std::string("invalid regex: ") + ToString(regex)),
@@ -178,29 +382,26 @@ std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern) {
         }
       }
     } else if (var_exists && (!regex_exists || var_start < regex_start)) {
-      const auto consumed =
-          RE2::Consume(&pattern, "(.*?)\\[\\[(.*?)\\]\\]", &fixed, &var);
-      if (!consumed) {
-        assert(consumed &&
-               "Did not make forward progress for var in check rule");
-      }
+      // Split off the text before the first "[[", and the variable between
+      // it and the first "]]", which must follow it.
+      fixed = pattern.substr(0, var_start);
+      var = pattern.substr(var_start + 2, var_end - var_start - 2);
+      pattern.remove_prefix(var_end + 2);
       if (!fixed.empty()) {
-        parts.emplace_back(
-            effcee::make_unique<Check::Part>(Type::Fixed, fixed));
+        parts.emplace_back(Type::Fixed, fixed);
       }
       if (!var.empty()) {
         auto colon = var.find(":");
         // A colon at the end is useless anyway, so just make it a variable
         // use.
         if (colon == StringPiece::npos || colon == var.size() - 1) {
-          parts.emplace_back(
-              effcee::make_unique<Check::Part>(Type::VarUse, var));
+          parts.emplace_back(Type::VarUse, var, SlotFor(var, slots));
         } else {
           StringPiece name = var.substr(0, colon);
           StringPiece expression = var.substr(colon + 1, StringPiece::npos);
-          parts.emplace_back(effcee::make_unique<Check::Part>(
-              Type::VarDef, var, name, expression));
-          if (parts.back()->NumCapturingGroups() < 0) {
+          parts.emplace_back(Type::VarDef, var, name, expression,
+                             SlotFor(name, slots));
+          if (parts.back().NumCapturingGroups() < 0) {
             return std::make_pair(
                 Result(
                     Result::Status::BadRule,
@@ -212,7 +413,7 @@ std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern) {
       }
     } else {
       // There is no regex, no var def, no var use.  Must be a fixed string.
-      parts.push_back(effcee::make_unique<Check::Part>(Type::Fixed, pattern));
+      parts.emplace_back(Type::Fixed, pattern);
       break;
     }
   }
@@ -220,49 +421,166 @@ std::pair<Result, Check::Parts> PartsForPattern(StringPiece pattern) {
   return std::make_pair(Result(Result::Status::Ok), std::move(parts));
 }
 
+// Returns true if |c| is whitespace, as matched by "\s" in RE2.
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+// Finds the first check rule in |line|, which must be ASCII.  Returns true
+// and sets |type|, |param|, and the index of the rule's prefix |which| if
+// there is one.  Has the same effect as matching the regex
+//    .*?(PREFIX1|PREFIX2|...)(-NEXT|-SAME|-DAG|-LABEL|-NOT)?:\s*(.*?)\s*$
+// where the PREFIXes are those in |prefixes|, but without the overhead of
+// the regex engine.
+bool FindRule(StringPiece line, const effcee::LiteralSet& prefixes,
+              Type* type, StringPiece* param, size_t* which) {
+  for (size_t start = 0;;) {
+    const size_t pos = prefixes.Find(line.substr(start));
+    if (pos == StringPiece::npos) return false;
+    start += pos;
+    // Try each prefix occurring here, in order.
+    for (size_t i = 0; i < prefixes.literals().size(); ++i) {
+      if (!prefixes.MatchesAt(line, start, i)) continue;
+      const StringPiece rest =
+          line.substr(start + prefixes.literals()[i].size());
+      // Try the suffixes.  They differ, and each is followed by a colon.
+      for (const auto& entry : TypeStringTable()) {
+        const StringPiece suffix = entry.first;
+        if (rest.size() > suffix.size() && rest[suffix.size()] == ':' &&
+            rest.substr(0, suffix.size()) == suffix) {
+          StringPiece value = rest.substr(suffix.size() + 1);
+          while (!value.empty() && IsSpace(value[0])) value.remove_prefix(1);
+          while (!value.empty() && IsSpace(value[value.size() - 1])) {
+            value.remove_suffix(1);
+          }
+          *type = entry.second;
+          *param = value;
+          *which = i;
+          return true;
+        }
+      }
+    }
+    // Not a rule.  Look for a later prefix.
+    ++start;
+  }
+}
+
+// Returns the prefixes separated by commas.
+std::string JoinPrefixes(const std::vector<std::string>& prefixes) {
+  std::string joined;
+  for (const auto& prefix : prefixes) {
+    if (!joined.empty()) joined += ", ";
+    joined += prefix;
+  }
+  return joined;
+}
+
+// Returns the regex equivalent to FindRule for the given prefixes.  It
+// captures the prefix, the suffix, and the parameter of a rule.
+std::string RuleRegex(const std::vector<std::string>& prefixes) {
+  std::string alternatives;
+  for (const auto& prefix : prefixes) {
+    if (!alternatives.empty()) alternatives += '|';
+    alternatives += RE2::QuoteMeta(prefix);
+  }
+  return ".*?(" + alternatives + ")(-NEXT|-SAME|-DAG|-LABEL|-NOT)?" +
+         ":\\s*(.*?)\\s*$";
+}
+
 }  // namespace
 
 std::pair<Result, CheckList> ParseChecks(StringPiece str,
-                                         const Options& options) {
+                                         const Options& options,
+                                         MatchStats* stats) {
   // Returns a pair whose first member is a result constructed from the
   // given status and message, and the second member is an empy pattern.
   auto failure = [](Status status, StringPiece message) {
     return std::make_pair(Result(status, message), CheckList{});
   };
 
-  if (options.prefix().size() == 0)
-    return failure(Status::BadOption, "Rule prefix is empty");
-  if (RE2::FullMatch(options.prefix(), "\\s+"))
-    return failure(Status::BadOption,
-                   "Rule prefix is whitespace.  That's silly.");
+  const auto& prefixes = options.prefixes();
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    if (prefixes[i].size() == 0)
+      return failure(Status::BadOption, "Rule prefix is empty");
+    if (RE2::FullMatch(prefixes[i], "\\s+"))
+      return failure(Status::BadOption,
+                     "Rule prefix is whitespace.  That's silly.");
+    if (std::find(prefixes.begin(), prefixes.begin() + i, prefixes[i]) !=
+        prefixes.begin() + i)
+      return failure(Status::BadOption,
+                     "Rule prefix is repeated: " + prefixes[i]);
+  }
 
   CheckList check_list;
+  VarSlots var_slots;
+  // The prefix of the first check rule.
+  StringPiece first_prefix;
 
-  const auto quoted_prefix = RE2::QuoteMeta(options.prefix());
-  // Match the following parts:
-  //    .*?               - Text that is not the rule prefix
-  //    quoted_prefix     - A Simple Check prefix
+  // Most lines are ASCII, and are scanned for a rule by FindRule.  Other
+  // lines use the equivalent regex, since RE2's "." does not match invalid
+  // UTF-8.  The regex matches the following parts:
+  //    .*?               - Text that is not a rule prefix
+  //    (P1|P2)           - A Simple Check prefix, from any of the prefixes
   //    (-NEXT|-SAME)?    - An optional check type suffix. Two shown here.
   //    :                 - Colon
   //    \s*               - Whitespace
   //    (.*?)             - Captured parameter
   //    \s*               - Whitespace
   //    $                 - End of line
-
-  const RE2 regexp(std::string(".*?") + quoted_prefix +
-                   "(-NEXT|-SAME|-DAG|-LABEL|-NOT)?"
-                   ":\\s*(.*?)\\s*$");
+  TraceEventSink* const sink = options.trace_event_sink();
+  const effcee::LiteralSet prefix_set(prefixes);
+  std::unique_ptr<RE2> regexp;
   Cursor cursor(str);
   while (!cursor.Exhausted()) {
     const auto line = cursor.RestOfLine();
 
+    Type type = Type::Simple;
     StringPiece matched_param;
-    StringPiece suffix;
-    if (RE2::PartialMatch(line, regexp, &suffix, &matched_param)) {
-      const Type type = TypeForSuffix(suffix);
-      auto parts = PartsForPattern(matched_param);
+    StringPiece matched_prefix;
+    bool found = false;
+    if (IsAscii(line)) {
+      size_t which = 0;
+      found = FindRule(line, prefix_set, &type, &matched_param, &which);
+      if (found) matched_prefix = prefixes[which];
+    } else {
+      if (!regexp) {
+        TraceSpan span(options.trace_event_sink(), "CompileRegex", "parse");
+        span.AddArg("regex", "check rule pattern");
+        regexp = effcee::make_unique<RE2>(RuleRegex(prefixes));
+        if (stats) ++stats->regexes_compiled;
+      }
+      StringPiece suffix;
+      found = RE2::PartialMatch(line, *regexp, &matched_prefix, &suffix,
+                                &matched_param);
+      if (stats) ++stats->regex_matches;
+      if (found) type = TypeForSuffix(suffix);
+    }
+    if (found) {
+      auto parts = PartsForPattern(matched_param, &var_slots);
       if (!parts.first) return std::make_pair(parts.first, CheckList());
-      check_list.push_back(Check(type, matched_param, std::move(parts.second)));
+      if (check_list.empty()) first_prefix = matched_prefix;
+      const auto compile_start =
+          sink ? StatsClock::now() : StatsClock::time_point();
+      check_list.emplace_back(type, matched_param, std::move(parts.second),
+                              options.regex_max_mem());
+      check_list.back().SetLocation(
+          cursor.line_num(), int(1 + matched_param.data() - line.data()));
+      const Check& check = check_list.back();
+      if (check.RegexTooLarge()) {
+        return failure(Status::ResourceExhausted,
+                       options.checks_name() + ":" +
+                           std::to_string(check.line_num()) + ":" +
+                           std::to_string(check.column()) +
+                           ": regex needs more than the memory limit of " +
+                           std::to_string(options.regex_max_mem()) +
+                           " bytes: " + ToString(matched_param));
+      }
+      if (stats) stats->regexes_compiled += check.NumRegexesCompiled();
+      if (sink && check.NumRegexesCompiled()) {
+        RecordSpan(sink, "CompileRegex", "parse", compile_start,
+                   {{"line", std::to_string(check.line_num())},
+                    {"regex", ToString(matched_param)}});
+      }
     }
     cursor.AdvanceLine();
   }
@@ -270,15 +588,15 @@ std::pair<Result, CheckList> ParseChecks(StringPiece str,
   if (check_list.empty()) {
     return failure(
         Status::NoRules,
-        std::string("No check rules specified. Looking for prefix ") +
-            options.prefix());
+        std::string("No check rules specified. Looking for prefix") +
+            (prefixes.size() > 1 ? "es " : " ") + JoinPrefixes(prefixes));
   }
 
   if (check_list[0].type() == Type::Same) {
-    return failure(Status::BadRule, std::string(options.prefix()) +
+    return failure(Status::BadRule, ToString(first_prefix) +
                                         "-SAME can't be the first check rule");
   }
 
-  return std::make_pair(Result(Result::Status::Ok), check_list);
+  return std::make_pair(Result(Result::Status::Ok), std::move(check_list));
 }
 }  // namespace effcee
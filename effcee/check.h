@@ -15,6 +15,8 @@
 #ifndef EFFCEE_CHECK_H
 #define EFFCEE_CHECK_H
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -22,12 +24,91 @@
 #include <vector>
 
 #include "effcee.h"
-#include "make_unique.h"
 
 namespace effcee {
 
-// A mapping from a name to a string value.
-using VarMapping = std::unordered_map<std::string, std::string>;
+// The values of variables, indexed by slot.  ParseChecks assigns each
+// distinct variable name in a check list a slot, counting from 0, so that
+// matching never looks a variable up by name.
+//
+// A value refers to the text it was matched in, and is not copied when it
+// is set.  Call Own() before that text goes away.
+class VarMapping {
+ public:
+  // Returns true if the variable in |slot| has a value.
+  bool IsSet(int slot) const {
+    return slot >= 0 && size_t(slot) < slots_.size() && slots_[slot].is_set;
+  }
+
+  // Returns the value of the variable in |slot|, which must be set.
+  StringPiece Get(int slot) const {
+    const Slot& entry = slots_[slot];
+    return entry.is_owned ? StringPiece(entry.owned) : entry.value;
+  }
+
+  // Returns the value of the variable in |slot|, which must be set, quoted
+  // for use in a regex.  The quoted form is computed once per value.
+  const std::string& GetQuoted(int slot) const {
+    Slot& entry = slots_[slot];
+    if (!entry.is_quoted) {
+      entry.quoted = RE2::QuoteMeta(Get(slot));
+      entry.is_quoted = true;
+    }
+    return entry.quoted;
+  }
+
+  // Sets the value of the variable in |slot| to refer to |value|.
+  void Set(int slot, StringPiece value) {
+    if (size_t(slot) >= slots_.size()) slots_.resize(slot + 1);
+    Slot& entry = slots_[slot];
+    if (!entry.is_set || entry.is_owned) borrowed_.push_back(slot);
+    entry.value = value;
+    entry.is_set = true;
+    entry.is_owned = false;
+    entry.is_quoted = false;
+  }
+
+  // Copies the values that still refer to the text they were matched in.
+  // The storage for earlier copies is reused.
+  void Own() {
+    for (const int slot : borrowed_) {
+      Slot& entry = slots_[slot];
+      entry.owned.assign(entry.value.data(), entry.value.size());
+      entry.value = StringPiece();
+      entry.is_owned = true;
+    }
+    borrowed_.clear();
+  }
+
+  // Returns true if no variable is set.
+  bool empty() const {
+    return std::none_of(slots_.begin(), slots_.end(),
+                        [](const Slot& entry) { return entry.is_set; });
+  }
+
+ private:
+  struct Slot {
+    // The value, unless it is owned.
+    StringPiece value;
+    // The value, when Own() has been called since it was set.
+    std::string owned;
+    // The value quoted for use in a regex, when computed.
+    std::string quoted;
+    bool is_set = false;
+    bool is_owned = false;
+    bool is_quoted = false;
+  };
+  mutable std::vector<Slot> slots_;
+  // The slots whose values are not owned.
+  std::vector<int> borrowed_;
+};
+
+// The slot of each variable name in a check list.
+using VarSlots = std::unordered_map<std::string, int>;
+
+// The variable definitions matched by a check: pairs of variable name and
+// matched substring.
+using VarCaptures = std::vector<std::pair<StringPiece, StringPiece>>;
 
 // A single check indicating something to be matched.
 //
@@ -59,19 +140,24 @@ class Check {
       VarUse,  // A variable use
     };
 
-    Part(Type type, StringPiece param)
+    // Constructs a part.  A VarUse part also needs the slot of the
+    // variable.
+    Part(Type type, StringPiece param, int slot = -1)
         : type_(type),
           param_(param),
           name_(),
           expression_(),
+          slot_(slot),
           num_capturing_groups_(CountCapturingGroups()) {}
 
     // A constructor for a VarDef variant.
-    Part(Type type, StringPiece param, StringPiece name, StringPiece expr)
+    Part(Type type, StringPiece param, StringPiece name, StringPiece expr,
+         int slot)
         : type_(type),
           param_(param),
           name_(name),
           expression_(expr),
+          slot_(slot),
           num_capturing_groups_(CountCapturingGroups()) {}
 
     // Returns true if this part might match a target string.  The only case where
@@ -87,6 +173,10 @@ class Check {
     // part, and 0 for other parts.
     int NumCapturingGroups() const { return num_capturing_groups_; }
 
+    // Accessors.
+    Type type() const { return type_; }
+    StringPiece param() const { return param_; }
+
     // If this is a VarDef, then returns the name of the variable. Otherwise
     // returns an empty string.
     StringPiece VarDefName() const { return name_; }
@@ -97,6 +187,10 @@ class Check {
       return type_ == Type::VarUse ? param_ : "";
     }
 
+    // If this is a VarDef or VarUse, then returns the slot of the variable.
+    // Otherwise returns -1.
+    int VarSlot() const { return slot_; }
+
    private:
     // Computes the number of capturing groups in this part. This is zero
     // for Fixed and VarUse parts.
@@ -112,16 +206,28 @@ class Check {
     StringPiece name_;
     // For a VarDef, the regex matching the new value for the variable.
     StringPiece expression_;
+    // For a VarDef or VarUse, the slot of the variable.
+    int slot_;
     // The number of capturing subgroups in the regex for a Regex or VarDef
     // part, and 0 for other kinds of parts.
     int num_capturing_groups_;
   };
 
-  using Parts = std::vector<std::unique_ptr<Part>>;
+  // The parts of a check are held by value, in one contiguous array.
+  using Parts = std::vector<Part>;
 
   // MSVC needs a default constructor.  However, a default-constructed Check
   // instance can't be used for matching.
-  Check() : type_(Type::Simple) {}
+  Check()
+      : type_(Type::Simple),
+        line_num_(0),
+        column_(0),
+        is_literal_(false),
+        num_captures_(0),
+        regex_max_mem_(0),
+        probed_regex_(false),
+        regex_too_large_(false),
+        line_searchable_(false) {}
 
   // Construct a Check object of the given type and fixed parameter string.
   // In particular, this retains a StringPiece reference to the |param|
@@ -130,33 +236,45 @@ class Check {
   Check(Type type, StringPiece param);
 
   // Construct a Check object of the given type, with given parameter string
-  // and specified parts.
-  Check(Type type, StringPiece param, Parts&& parts)
-      : type_(type), param_(param), parts_(std::move(parts)) {}
+  // and specified parts.  If |regex_max_mem| is positive, it is the most
+  // memory in bytes that RE2 may use for the check's regex.
+  Check(Type type, StringPiece param, Parts&& parts,
+        int64_t regex_max_mem = 0);
 
-  // Move constructor.
-  Check(Check&& other) : type_(other.type_), param_(other.param_) {
-    parts_.swap(other.parts_);
-  }
-  // Copy constructor.
-  Check(const Check& other) : type_(other.type_), param_(other.param_) {
-    for (const auto& part : other.parts_) {
-      parts_.push_back(effcee::make_unique<Part>(*part));
-    }
-  }
-  // Copy and move assignment.
-  Check& operator=(Check other) {
-    type_ = other.type_;
-    param_ = other.param_;
-    std::swap(parts_, other.parts_);
-    return *this;
-  }
+  // A check is movable but not copyable, since it owns its compiled regex.
+  Check(Check&&) = default;
+  Check& operator=(Check&&) = default;
+  Check(const Check&) = delete;
+  Check& operator=(const Check&) = delete;
 
   // Accessors.
   Type type() const { return type_; }
   StringPiece param() const { return param_; }
   const Parts& parts() const { return parts_; }
 
+  // Returns the 1-based line and column of the parameter in the check rules
+  // text.  These are 0 if the location was never set.
+  int line_num() const { return line_num_; }
+  int column() const { return column_; }
+
+  // Records the location of the parameter in the check rules text.  Returns
+  // this object.
+  Check& SetLocation(int line_num, int column) {
+    line_num_ = line_num;
+    column_ = column;
+    return *this;
+  }
+
+  // Returns the literal strings that must occur, in order and without
+  // overlapping, in any text matched by this check.
+  const std::vector<StringPiece>& required_literals() const {
+    return required_literals_;
+  }
+
+  // Returns true if |str| contains the required literals, in order.  When
+  // this is false, the check can't match |str|.
+  bool HasRequiredLiterals(StringPiece str) const;
+
   // Tries to match the given string, using |vars| as the variable mapping
   // context.  A variable use, e.g. '[[X]]', matches the current value for
   // that variable in vars, 'X' in this case.  A variable definition,
@@ -166,17 +284,108 @@ class Check {
   // of named variables in |vars| with the strings they matched. Otherwise
   // returns false and does not update |str| or |captured|.  Assumes this
   // instance is not default-constructed.
-  bool Matches(StringPiece* str, StringPiece* captured, VarMapping* vars) const;
+  // If |var_captures| is not null, it is also set to the name and matched
+  // substring of each variable definition.  If |stats| is not null, the
+  // regexes compiled and run, and the variables defined, are counted in it.
+  bool Matches(StringPiece* str, StringPiece* captured, VarMapping* vars,
+               VarCaptures* var_captures = nullptr,
+               MatchStats* stats = nullptr) const;
+
+  // Searches all the lines of |text| at once for where this check might
+  // match.  Returns an offset in |text|, such that the check matches no line
+  // before the one holding that offset.  Matching a line means matching the
+  // rest of it, as Matches does, where the first line starts at the start of
+  // |text|.  Returns StringPiece::npos if the check matches no line of
+  // |text|.  If |stats| is not null, the regexes compiled and run are
+  // counted in it.
+  size_t Search(StringPiece text, const VarMapping& vars,
+                MatchStats* stats = nullptr) const;
+
+  // Returns the number of regexes compiled when this check was made.
+  size_t NumRegexesCompiled() const;
+
+  // Returns true if the check's regex needs more memory than the limit it
+  // was made with.  For a check using variables, this is the regex with the
+  // variable uses left out.
+  bool RegexTooLarge() const { return regex_too_large_; }
 
  private:
+  // Computes the capture bookkeeping and required literals for the parts.
+  // Decides whether the check can be matched as a literal string, and
+  // otherwise compiles the consume regex if it does not depend on variable
+  // values.
+  void Compile();
+
+  // Matches a check consisting of a single fixed part by plain substring
+  // search.  Has the same effect as Matches.
+  bool MatchesLiteral(StringPiece* str, StringPiece* captured,
+                      MatchStats* stats) const;
+
+  // Returns the options for compiling the check's regex.
+  RE2::Options RegexOptions() const;
+
+  // Returns the regex used to match this check, given the variable mapping.
+  // It matches any minimal prefix, then the pattern of interest in a
+  // capturing group.
+  std::string ConsumeRegex(const VarMapping& vars) const;
+  // Returns the regex used to search many lines for this check, given the
+  // variable mapping.  It is the pattern of interest alone.
+  std::string SearchRegex(const VarMapping& vars) const;
+
   // The type of check.
   Type type_;
 
   // The parameter as given in user input, if any.
   StringPiece param_;
 
+  // The 1-based line and column of the parameter in the check rules text,
+  // or 0 if unknown.
+  int line_num_;
+  int column_;
+
   // The parameter, broken down into parts.
   Parts parts_;
+
+  // True if the check is a single fixed ASCII string, and is matched by
+  // substring search instead of by a regex.
+  bool is_literal_;
+
+  // The compiled consume regex, if this check has no variable uses.
+  // Otherwise it is null, and the regex is built for each match attempt,
+  // since it depends on variable values.
+  std::unique_ptr<const RE2> regex_;
+
+  // The number of captures in the consume regex, including the whole match.
+  int num_captures_;
+
+  // The memory limit for the regex, or 0 for RE2's default.
+  int64_t regex_max_mem_;
+  // True if a regex was compiled only to check it against the memory limit.
+  bool probed_regex_;
+  // True if the regex needs more memory than the limit.
+  bool regex_too_large_;
+
+  // True if a search of many lines with the search regex finds every match
+  // on a single line.  This is false when the pattern has an assertion about
+  // the start or end of the text, since those differ between a single line
+  // and many.
+  bool line_searchable_;
+  // The compiled search regex, if this is a NOT check without variable uses
+  // or required literals, and it is line searchable.  Otherwise null.
+  std::unique_ptr<const RE2> search_regex_;
+
+  // A variable definition in this check.
+  struct VarDefCapture {
+    // The index of its capture in the consume regex.
+    int index;
+    // The slot and name of the variable.
+    int slot;
+    StringPiece name;
+  };
+  std::vector<VarDefCapture> var_def_captures_;
+
+  // The fixed strings that any match must contain, in order.
+  std::vector<StringPiece> required_literals_;
 };
 
 // Equality operator for Check.
@@ -193,10 +402,13 @@ using CheckList = std::vector<Check>;
 
 // Parses |checks_string|, returning a Result status object and the sequence
 // of recognized checks, taking |options| into account.  The result status
-// object indicates success, or failure with a message.
+// object indicates success, or failure with a message.  Variables are given
+// slots in the order their names first appear.  If |stats| is not null, the
+// regexes compiled are counted in it.
 // TODO(dneto): Only matches simple checks for now.
 std::pair<Result, CheckList> ParseChecks(StringPiece checks_string,
-                                         const Options& options);
+                                         const Options& options,
+                                         MatchStats* stats = nullptr);
 
 }  // namespace effcee
 
@@ -33,8 +33,22 @@ using ::testing::ValuesIn;
 using Part = effcee::Check::Part;
 using Status = effcee::Result::Status;
 using Type = Check::Type;
+using VarCaptures = effcee::VarCaptures;
 using VarMapping = effcee::VarMapping;
 
+// The type and parameter of each check in a check list.
+using TypedParams = std::vector<std::pair<Type, std::string>>;
+
+// Returns the type and parameter of each check in |checks|.  Checks can't be
+// copied, so tests compare these instead.
+TypedParams TypesAndParams(const CheckList& checks) {
+  TypedParams result;
+  for (const auto& check : checks) {
+    result.emplace_back(check.type(), std::string(check.param()));
+  }
+  return result;
+}
+
 // Check class
 
 // Returns a vector of all Check types.
@@ -141,60 +155,152 @@ TEST(ParseChecks, FailWhenChecksAbsentWithCustomPrefix) {
 TEST(ParseChecks, FindSimpleCheck) {
   const auto parsed = ParseChecks("CHECK: now", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckWithCustomPrefix) {
   const auto parsed = ParseChecks("FOO: how", Options().SetPrefix("FOO"));
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "how")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "how"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckWithCustomPrefixHavingRegexpMetachars) {
   const auto parsed = ParseChecks("[::alpha::]^\\d: how",
                                   Options().SetPrefix("[::alpha::]^\\d"));
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "how")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "how"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckPartwayThroughLine) {
   const auto parsed = ParseChecks("some other garbageCHECK: now", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckCheckListWithoutSurroundingWhitespace) {
   const auto parsed = ParseChecks("CHECK:now", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckCheckListWhileStrippingSurroundingWhitespace) {
   const auto parsed = ParseChecks("CHECK: \t   now\t\t  ", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}}));
 }
 
 TEST(ParseChecks, FindSimpleCheckCountsLinesCorrectly) {
   const auto parsed = ParseChecks("\n\nCHECK: now", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}}));
 }
 
 TEST(ParseChecks, FindSimpleChecksOnSeparateLines) {
   const auto parsed =
       ParseChecks("CHECK: now\n\n\nCHECK: and \n CHECK: then", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second, Eq(CheckList({Check(Type::Simple, "now"),
-                                           Check(Type::Simple, "and"),
-                                           Check(Type::Simple, "then")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}, {Type::Simple, "and"},
+                             {Type::Simple, "then"}}));
+}
+
+TEST(ParseChecks, RecordsLocationOfEachCheck) {
+  const auto parsed =
+      ParseChecks("CHECK: now\n\n  CHECK-NEXT:  then\nCHECK:", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  ASSERT_THAT(parsed.second.size(), Eq(3));
+  EXPECT_THAT(parsed.second[0].line_num(), Eq(1));
+  EXPECT_THAT(parsed.second[0].column(), Eq(8));
+  EXPECT_THAT(parsed.second[1].line_num(), Eq(3));
+  EXPECT_THAT(parsed.second[1].column(), Eq(16));
+  EXPECT_THAT(parsed.second[2].line_num(), Eq(4));
+  EXPECT_THAT(parsed.second[2].column(), Eq(7));
+}
+
+TEST(CheckLocation, UnsetByDefault) {
+  const Check check(Type::Simple, "abc");
+  EXPECT_THAT(check.line_num(), Eq(0));
+  EXPECT_THAT(check.column(), Eq(0));
+}
+
+TEST(CheckLocation, SetLocation) {
+  Check check(Type::Simple, "abc");
+  EXPECT_THAT(&check.SetLocation(3, 4), Eq(&check));
+  EXPECT_THAT(check.line_num(), Eq(3));
+  EXPECT_THAT(check.column(), Eq(4));
 }
 
 TEST(ParseChecks, FindSimpleChecksOnlyOncePerLine) {
   const auto parsed = ParseChecks("CHECK: now CHECK: then", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second,
-              Eq(CheckList({Check(Type::Simple, "now CHECK: then")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now CHECK: then"}}));
+}
+
+TEST(ParseChecks, FindCheckAfterPrefixWithoutColon) {
+  const auto parsed =
+      ParseChecks("CHECK-NEXTX: a CHECK-NOT b CHECK-DAG: now", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::DAG, "now"}}));
+}
+
+TEST(ParseChecks, FindCheckAfterRepeatedPrefix) {
+  const auto parsed = ParseChecks("CHECKCHECK-DAG:now", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::DAG, "now"}}));
+}
+
+TEST(ParseChecks, FindCheckStrippingCarriageReturn) {
+  const auto parsed = ParseChecks("CHECK: now\r\nCHECK: \f then\r", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "now"}, {Type::Simple, "then"}}));
+}
+
+TEST(ParseChecks, FindCheckOnNonAsciiLine) {
+  const auto parsed =
+      ParseChecks("caf\xc3\xa9 CHECK-NOT: cr\xc3\xa8me  \n", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Not, "cr\xc3\xa8me"}}));
+  EXPECT_THAT(parsed.second[0].column(), Eq(18));
+}
+
+TEST(ParseChecks, NoCheckOnLineWithInvalidUtf8) {
+  // RE2's "." does not match invalid UTF-8, so the first line is not a rule.
+  const auto parsed = ParseChecks("CHECK: a\xff\nCHECK: b", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "b"}}));
+}
+
+TEST(ParseChecks, SplitsPartsAtFirstDelimiters) {
+  const auto parsed =
+      ParseChecks("CHECK: a]]b{{c{d}}e[[X:f]]g[[Y]]h", Options());
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  ASSERT_THAT(parsed.second.size(), Eq(1u));
+  const auto& parts = parsed.second[0].parts();
+  ASSERT_THAT(parts.size(), Eq(7u));
+  EXPECT_THAT(parts[0].type(), Eq(Part::Type::Fixed));
+  EXPECT_THAT(parts[0].param(), Eq("a]]b"));
+  EXPECT_THAT(parts[1].type(), Eq(Part::Type::Regex));
+  EXPECT_THAT(parts[1].param(), Eq("c{d"));
+  EXPECT_THAT(parts[2].param(), Eq("e"));
+  EXPECT_THAT(parts[3].type(), Eq(Part::Type::VarDef));
+  EXPECT_THAT(parts[3].VarDefName(), Eq("X"));
+  EXPECT_THAT(parts[4].param(), Eq("g"));
+  EXPECT_THAT(parts[5].type(), Eq(Part::Type::VarUse));
+  EXPECT_THAT(parts[5].VarUseName(), Eq("Y"));
+  EXPECT_THAT(parts[6].param(), Eq("h"));
 }
 
 // Test parsing of the different check rule types.
@@ -210,8 +316,8 @@ TEST_P(ParseChecksTypeTest, Successful) {
   const std::string input = prefix + ": here\n" + prefix + type_str + ": now";
   const auto parsed = ParseChecks(input, Options().SetPrefix(prefix));
   EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
-  EXPECT_THAT(parsed.second,
-              Eq(CheckList({Check(Type::Simple, "here"), Check(type, "now")})));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "here"}, {type, "now"}}));
 }
 
 // Returns a vector of pairs. Each pair has first member being a check type
@@ -238,7 +344,7 @@ TEST_P(ParseChecksTypeFailTest, FailureWhenNoColon) {
   const std::string input = prefix + type_str + "BAD now";
   const auto parsed = ParseChecks(input, Options().SetPrefix(prefix));
   EXPECT_THAT(parsed.first.status(), Eq(Status::NoRules));
-  EXPECT_THAT(parsed.second, Eq(CheckList{}));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{}));
 }
 
 INSTANTIATE_TEST_SUITE_P(AllCheckTypes, ParseChecksTypeFailTest,
@@ -250,7 +356,7 @@ TEST(ParseChecks, BadRegexpMatchTrailingSlashFails) {
   const auto parsed = ParseChecks("CHECK: {{\\}}", Options());
   EXPECT_THAT(parsed.first.status(), Eq(Status::BadRule));
   EXPECT_THAT(parsed.first.message(), HasSubstr("invalid regex: \\"));
-  EXPECT_THAT(parsed.second, Eq(CheckList({})));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{}));
 }
 
 TEST(ParseChecks, BadRegexpVardefUnboundOptionalFails) {
@@ -258,7 +364,7 @@ TEST(ParseChecks, BadRegexpVardefUnboundOptionalFails) {
   EXPECT_THAT(parsed.first.status(), Eq(Status::BadRule));
   EXPECT_THAT(parsed.first.message(),
               HasSubstr("invalid regex in variable definition for VAR: ?"));
-  EXPECT_THAT(parsed.second, Eq(CheckList({})));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{}));
 }
 
 TEST(ParseChecks, CheckSameCantBeFirst) {
@@ -266,7 +372,7 @@ TEST(ParseChecks, CheckSameCantBeFirst) {
   EXPECT_THAT(parsed.first.status(), Eq(Status::BadRule));
   EXPECT_THAT(parsed.first.message(),
               HasSubstr("CHECK-SAME can't be the first check rule"));
-  EXPECT_THAT(parsed.second, Eq(CheckList({})));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{}));
 }
 
 TEST(ParseChecks, CheckSameCantBeFirstDifferentPrefix) {
@@ -274,13 +380,103 @@ TEST(ParseChecks, CheckSameCantBeFirstDifferentPrefix) {
   EXPECT_THAT(parsed.first.status(), Eq(Status::BadRule));
   EXPECT_THAT(parsed.first.message(),
               HasSubstr("BOO-SAME can't be the first check rule"));
-  EXPECT_THAT(parsed.second, Eq(CheckList({})));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{}));
+}
+
+// Multiple prefixes
+
+TEST(ParseChecks, FailWhenOneOfPrefixesIsEmpty) {
+  const auto parsed =
+      ParseChecks("CHECK: now", Options().SetPrefixes({"CHECK", ""}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::BadOption));
+  EXPECT_THAT(parsed.first.message(), Eq("Rule prefix is empty"));
+}
+
+TEST(ParseChecks, FailWhenPrefixListIsEmpty) {
+  const auto parsed = ParseChecks("CHECK: now", Options().SetPrefixes({}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::BadOption));
+  EXPECT_THAT(parsed.first.message(), Eq("Rule prefix is empty"));
+}
+
+TEST(ParseChecks, FailWhenPrefixIsRepeated) {
+  const auto parsed = ParseChecks(
+      "CHECK: now", Options().SetPrefixes({"CHECK", "FOO", "CHECK"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::BadOption));
+  EXPECT_THAT(parsed.first.message(), Eq("Rule prefix is repeated: CHECK"));
+}
+
+TEST(ParseChecks, FailWhenChecksAbsentWithPrefixes) {
+  const auto parsed =
+      ParseChecks("CHECK: now", Options().SetPrefixes({"FOO", "BAR"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::NoRules));
+  EXPECT_THAT(parsed.first.message(),
+              Eq("No check rules specified. Looking for prefixes FOO, BAR"));
+}
+
+TEST(ParseChecks, FindChecksWithPrefixesInOrderOfAppearance) {
+  const auto parsed = ParseChecks(
+      "FOO: a\nCHECK: b\nBAR-NOT: c\nFOO-NEXT: d\nCHECK-DAG: e",
+      Options().SetPrefixes({"CHECK", "FOO", "BAR"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "a"}, {Type::Simple, "b"},
+                             {Type::Not, "c"}, {Type::Next, "d"},
+                             {Type::DAG, "e"}}));
+}
+
+TEST(ParseChecks, FindCheckWithPrefixExtendingAnother) {
+  const auto parsed =
+      ParseChecks("CHECK-O2: a\nCHECK-O2-SAME: b\nCHECK-NEXT: c",
+                  Options().SetPrefixes({"CHECK", "CHECK-O2"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "a"}, {Type::Same, "b"},
+                             {Type::Next, "c"}}));
+}
+
+TEST(ParseChecks, FindEarliestCheckAmongPrefixes) {
+  const auto parsed = ParseChecks(
+      "x BAR: a FOO: b", Options().SetPrefixes({"FOO", "BAR"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Simple, "a FOO: b"}}));
+}
+
+TEST(ParseChecks, EarlierPrefixWinsAtSamePosition) {
+  const auto parsed = ParseChecks(
+      "CHECK-NOT: a", Options().SetPrefixes({"CHECK", "CHECK-NOT"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second), Eq(TypedParams{{Type::Not, "a"}}));
+
+  const auto reversed = ParseChecks(
+      "CHECK-NOT: a", Options().SetPrefixes({"CHECK-NOT", "CHECK"}));
+  EXPECT_THAT(reversed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(reversed.second),
+              Eq(TypedParams{{Type::Simple, "a"}}));
+}
+
+TEST(ParseChecks, FindChecksWithPrefixesOnNonAsciiLines) {
+  const auto parsed =
+      ParseChecks("\xc3\xa9 FOO-NEXT: \xc3\xa9\n\xc3\xa9 BAR: b",
+                  Options().SetPrefixes({"FOO", "BAR"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::Ok));
+  EXPECT_THAT(TypesAndParams(parsed.second),
+              Eq(TypedParams{{Type::Next, "\xc3\xa9"}, {Type::Simple, "b"}}));
+}
+
+TEST(ParseChecks, CheckSameCantBeFirstNamesItsPrefix) {
+  const auto parsed = ParseChecks("x\nBAR-SAME: now\nFOO: later",
+                                  Options().SetPrefixes({"FOO", "BAR"}));
+  EXPECT_THAT(parsed.first.status(), Eq(Status::BadRule));
+  EXPECT_THAT(parsed.first.message(),
+              HasSubstr("BAR-SAME can't be the first check rule"));
 }
 
 // Check::Matches
 struct CheckMatchCase {
   std::string input;
-  Check check;
+  Type type;
+  const char* param;
   bool expected;
   std::string remaining;
   std::string captured;
@@ -292,7 +488,8 @@ TEST_P(CheckMatchTest, Samples) {
   StringPiece str = GetParam().input;
   StringPiece captured;
   VarMapping vars;
-  const bool matched = GetParam().check.Matches(&str, &captured, &vars);
+  const Check check(GetParam().type, GetParam().param);
+  const bool matched = check.Matches(&str, &captured, &vars);
   EXPECT_THAT(matched, Eq(GetParam().expected))
       << "Failed on input " << GetParam().input;
   EXPECT_THAT(std::string(str.data(), str.size()), Eq(GetParam().remaining));
@@ -304,29 +501,275 @@ TEST_P(CheckMatchTest, Samples) {
 INSTANTIATE_TEST_SUITE_P(
     Simple, CheckMatchTest,
     ValuesIn(std::vector<CheckMatchCase>{
-        {"hello", Check(Type::Simple, "hello"), true, "", "hello"},
-        {"world", Check(Type::Simple, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Simple, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::Same, "hello"), true, "", "hello"},
-        {"world", Check(Type::Same, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Same, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::Next, "hello"), true, "", "hello"},
-        {"world", Check(Type::Next, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Next, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::DAG, "hello"), true, "", "hello"},
-        {"world", Check(Type::DAG, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::DAG, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::Label, "hello"), true, "", "hello"},
-        {"world", Check(Type::Label, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Label, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::Label, "hello"), true, "", "hello"},
-        {"world", Check(Type::Label, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Label, "hello"), true, " now", "hello"},
-        {"hello", Check(Type::Not, "hello"), true, "", "hello"},
-        {"world", Check(Type::Not, "hello"), false, "world", ""},
-        {"in hello now", Check(Type::Not, "hello"), true, " now", "hello"},
+        {"hello", Type::Simple, "hello", true, "", "hello"},
+        {"world", Type::Simple, "hello", false, "world", ""},
+        {"in hello now", Type::Simple, "hello", true, " now", "hello"},
+        {"hello", Type::Same, "hello", true, "", "hello"},
+        {"world", Type::Same, "hello", false, "world", ""},
+        {"in hello now", Type::Same, "hello", true, " now", "hello"},
+        {"hello", Type::Next, "hello", true, "", "hello"},
+        {"world", Type::Next, "hello", false, "world", ""},
+        {"in hello now", Type::Next, "hello", true, " now", "hello"},
+        {"hello", Type::DAG, "hello", true, "", "hello"},
+        {"world", Type::DAG, "hello", false, "world", ""},
+        {"in hello now", Type::DAG, "hello", true, " now", "hello"},
+        {"hello", Type::Label, "hello", true, "", "hello"},
+        {"world", Type::Label, "hello", false, "world", ""},
+        {"in hello now", Type::Label, "hello", true, " now", "hello"},
+        {"hello", Type::Label, "hello", true, "", "hello"},
+        {"world", Type::Label, "hello", false, "world", ""},
+        {"in hello now", Type::Label, "hello", true, " now", "hello"},
+        {"hello", Type::Not, "hello", true, "", "hello"},
+        {"world", Type::Not, "hello", false, "world", ""},
+        {"in hello now", Type::Not, "hello", true, " now", "hello"},
+    }));
+
+INSTANTIATE_TEST_SUITE_P(
+    Literal, CheckMatchTest,
+    ValuesIn(std::vector<CheckMatchCase>{
+        {"", Type::Simple, "a", false, "", ""},
+        {"a(b)*c+d", Type::Simple, "(b)*c+", true, "d", "(b)*c+"},
+        {"aaab", Type::Simple, "aab", true, "", "aab"},
+        {"hell hello", Type::Simple, "hello", true, "", "hello"},
+        {"hello hello", Type::Simple, "hello", true, " hello",
+         "hello"},
+        // The match must not start after a newline.
+        {"one\nhello", Type::Simple, "hello", false, "one\nhello", ""},
+        {"hello\nhello", Type::Simple, "hello", true, "\nhello",
+         "hello"},
+        // The text skipped before the match must be valid UTF-8.
+        {"caf\xc3\xa9 hello", Type::Simple, "hello", true, "",
+         "hello"},
+        {"caf\xff hello", Type::Simple, "hello", false,
+         "caf\xff hello", ""},
+        {"\xffhello", Type::Simple, "\xffhello", false, "\xffhello",
+         ""},
     }));
 
+TEST(CheckMatch, SameCheckMatchesRepeatedly) {
+  const Check check(Type::Simple, "b+c");
+  for (StringPiece input : {"ab+cd", "xb+c", "b+c b+c"}) {
+    StringPiece captured;
+    VarMapping vars;
+    EXPECT_TRUE(check.Matches(&input, &captured, &vars));
+    EXPECT_THAT(captured, Eq("b+c"));
+  }
+}
+
+TEST(CheckMatch, MovedMatchesLikeOriginal) {
+  auto parsed = ParseChecks("CHECK: hel{{l+}}o", Options());
+  ASSERT_TRUE(parsed.first);
+  const Check moved(std::move(parsed.second[0]));
+  StringPiece input("say hello now");
+  StringPiece captured;
+  VarMapping vars;
+  EXPECT_TRUE(moved.Matches(&input, &captured, &vars));
+  EXPECT_THAT(input, Eq(" now"));
+  EXPECT_THAT(captured, Eq("hello"));
+}
+
+TEST(CheckMatch, VarDefUpdatedOnEachMatch) {
+  const auto parsed = ParseChecks("CHECK: x[[V:[0-9]+]]y", Options());
+  ASSERT_TRUE(parsed.first);
+  const Check& check = parsed.second[0];
+  VarMapping vars;
+  for (const std::string value : {"12", "345"}) {
+    const std::string text = "x" + value + "y";
+    StringPiece input(text);
+    StringPiece captured;
+    EXPECT_TRUE(check.Matches(&input, &captured, &vars));
+    EXPECT_THAT(vars.Get(0), Eq(value));
+  }
+}
+
+TEST(CheckMatch, VarUseTracksCurrentValue) {
+  const auto parsed = ParseChecks("CHECK: x[[V]]y", Options());
+  ASSERT_TRUE(parsed.first);
+  const Check& check = parsed.second[0];
+  VarMapping vars;
+  StringPiece captured;
+  vars.Set(0, "1");
+  StringPiece input("x2y x1y");
+  EXPECT_TRUE(check.Matches(&input, &captured, &vars));
+  EXPECT_THAT(captured, Eq("x1y"));
+  vars.Set(0, "2");
+  input = "x1y x2y";
+  EXPECT_TRUE(check.Matches(&input, &captured, &vars));
+  EXPECT_THAT(captured, Eq("x2y"));
+}
+
+TEST(CheckMatch, VarCapturesReferToInput) {
+  const auto parsed =
+      ParseChecks("CHECK: [[A:[a-z]+]]=[[B:[0-9]+]]", Options());
+  ASSERT_TRUE(parsed.first);
+  const Check& check = parsed.second[0];
+  VarMapping vars;
+  VarCaptures var_captures;
+  const std::string text = "set x=42;";
+  StringPiece input(text);
+  StringPiece captured;
+  EXPECT_TRUE(check.Matches(&input, &captured, &vars, &var_captures));
+  ASSERT_THAT(var_captures.size(), Eq(2u));
+  EXPECT_THAT(var_captures[0].first, Eq("A"));
+  EXPECT_THAT(var_captures[0].second, Eq("x"));
+  EXPECT_THAT(var_captures[0].second.data(), Eq(text.data() + 4));
+  EXPECT_THAT(var_captures[1].first, Eq("B"));
+  EXPECT_THAT(var_captures[1].second, Eq("42"));
+  EXPECT_THAT(var_captures[1].second.data(), Eq(text.data() + 6));
+}
+
+// Variable slots
+
+TEST(ParseChecks, VariablesGetSlotsInOrderOfFirstAppearance) {
+  const auto parsed = ParseChecks(
+      "CHECK: [[B]] [[A:x]]\nCHECK: [[A]] [[C:y]] [[B:z]]", Options());
+  ASSERT_TRUE(parsed.first);
+  const auto& first = parsed.second[0].parts();
+  const auto& second = parsed.second[1].parts();
+  EXPECT_THAT(first[0].VarSlot(), Eq(0));   // B
+  EXPECT_THAT(first[2].VarSlot(), Eq(1));   // A
+  EXPECT_THAT(second[0].VarSlot(), Eq(1));  // A
+  EXPECT_THAT(second[2].VarSlot(), Eq(2));  // C
+  EXPECT_THAT(second[4].VarSlot(), Eq(0));  // B
+}
+
+TEST(ParseChecks, FixedAndRegexPartsHaveNoSlot) {
+  const auto parsed = ParseChecks("CHECK: a{{b}}", Options());
+  ASSERT_TRUE(parsed.first);
+  for (const auto& part : parsed.second[0].parts()) {
+    EXPECT_THAT(part.VarSlot(), Eq(-1));
+  }
+}
+
+TEST(VarMapping, SetAndGetBySlot) {
+  VarMapping vars;
+  EXPECT_TRUE(vars.empty());
+  EXPECT_FALSE(vars.IsSet(0));
+  EXPECT_FALSE(vars.IsSet(-1));
+  vars.Set(2, "two");
+  EXPECT_FALSE(vars.empty());
+  EXPECT_FALSE(vars.IsSet(0));
+  EXPECT_TRUE(vars.IsSet(2));
+  EXPECT_THAT(vars.Get(2), Eq("two"));
+  vars.Set(2, "2");
+  EXPECT_THAT(vars.Get(2), Eq("2"));
+}
+
+TEST(VarMapping, ValueRefersToTextUntilOwned) {
+  VarMapping vars;
+  std::string text = "a+b";
+  vars.Set(0, text);
+  EXPECT_THAT(vars.Get(0).data(), Eq(text.data()));
+  EXPECT_THAT(vars.GetQuoted(0), Eq("a\\+b"));
+  vars.Own();
+  text = "xyz";
+  EXPECT_THAT(vars.Get(0), Eq("a+b"));
+  EXPECT_THAT(vars.GetQuoted(0), Eq("a\\+b"));
+  vars.Set(0, text);
+  EXPECT_THAT(vars.Get(0), Eq("xyz"));
+  EXPECT_THAT(vars.GetQuoted(0), Eq("xyz"));
+}
+
+// Check::required_literals
+
+TEST(CheckRequiredLiterals, FixedCheckRequiresItsText) {
+  const Check check(Type::Simple, "a{{b");
+  EXPECT_THAT(check.required_literals(),
+              Eq(std::vector<StringPiece>{"a{{b"}));
+}
+
+TEST(CheckRequiredLiterals, FixedPartsAreRequiredInOrder) {
+  const auto parsed =
+      ParseChecks("CHECK: OpStore [[PTR]] {{%[0-9]+}} end", Options());
+  ASSERT_TRUE(parsed.first);
+  EXPECT_THAT(parsed.second[0].required_literals(),
+              Eq(std::vector<StringPiece>{"OpStore ", " ", " end"}));
+}
+
+TEST(CheckRequiredLiterals, NoneForRegexOnly) {
+  const auto parsed = ParseChecks("CHECK: {{[0-9]+}}[[X:a]]", Options());
+  ASSERT_TRUE(parsed.first);
+  EXPECT_TRUE(parsed.second[0].required_literals().empty());
+}
+
+using CheckRequiredLiteralsRegexTest = ::testing::TestWithParam<std::string>;
+
+TEST_P(CheckRequiredLiteralsRegexTest, NoneWhenRegexAffectsFixedParts) {
+  const auto parsed = ParseChecks("CHECK: " + GetParam(), Options());
+  ASSERT_TRUE(parsed.first);
+  EXPECT_TRUE(parsed.second[0].required_literals().empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Samples, CheckRequiredLiteralsRegexTest,
+                         ValuesIn(std::vector<std::string>{
+                             "x{{|y}}", "{{(?i)}}abc", "{{a(?i)}}bc",
+                             "{{\\Q}}a.b"}));
+
+TEST(CheckRequiredLiterals, HasRequiredLiteralsNeedsOrder) {
+  const auto parsed = ParseChecks("CHECK: ab{{.*}}cd", Options());
+  ASSERT_TRUE(parsed.first);
+  const Check& check = parsed.second[0];
+  EXPECT_TRUE(check.HasRequiredLiterals("xxabyycdzz"));
+  EXPECT_TRUE(check.HasRequiredLiterals("abcd"));
+  EXPECT_FALSE(check.HasRequiredLiterals("cdab"));
+  EXPECT_FALSE(check.HasRequiredLiterals("abd"));
+  EXPECT_FALSE(check.HasRequiredLiterals("acd"));
+}
+
+TEST(CheckMatch, FlagsInRegexApplyToFollowingFixedPart) {
+  const auto parsed = ParseChecks("CHECK: {{(?i)}}abc", Options());
+  ASSERT_TRUE(parsed.first);
+  StringPiece input("xABC");
+  StringPiece captured;
+  VarMapping vars;
+  EXPECT_TRUE(parsed.second[0].Matches(&input, &captured, &vars));
+  EXPECT_THAT(captured, Eq("ABC"));
+}
+
+TEST(CheckMatch, AlternationInRegexAppliesToPrecedingFixedPart) {
+  const auto parsed = ParseChecks("CHECK: x{{|y}}", Options());
+  ASSERT_TRUE(parsed.first);
+  StringPiece input("ay");
+  StringPiece captured;
+  VarMapping vars;
+  EXPECT_TRUE(parsed.second[0].Matches(&input, &captured, &vars));
+  EXPECT_THAT(captured, Eq("y"));
+}
+
+// Check::Search
+
+TEST(CheckSearch, LiteralIsFoundOnAnyLine) {
+  const Check check(Type::Not, "b");
+  VarMapping vars;
+  EXPECT_THAT(check.Search("a\nxb\n", vars), Eq(3u));
+  EXPECT_THAT(check.Search("a\nc\n", vars), Eq(StringPiece::npos));
+}
+
+TEST(CheckSearch, RegexFindsEarliestCandidate) {
+  const auto parsed = ParseChecks("CHECK-NOT: {{[0-9]+}}", Options());
+  ASSERT_TRUE(parsed.first);
+  VarMapping vars;
+  EXPECT_THAT(parsed.second[0].Search("a\nb12\n3\n", vars), Eq(3u));
+  EXPECT_THAT(parsed.second[0].Search("a\nb\n", vars),
+              Eq(StringPiece::npos));
+}
+
+TEST(CheckSearch, AnchoredRegexMightMatchFirstLine) {
+  const auto parsed = ParseChecks("CHECK-NOT: {{^b}}", Options());
+  ASSERT_TRUE(parsed.first);
+  VarMapping vars;
+  EXPECT_THAT(parsed.second[0].Search("a\nb\n", vars), Eq(0u));
+}
+
+TEST(CheckSearch, UndefinedVariableMatchesNoLine) {
+  const auto parsed = ParseChecks("CHECK-NOT: {{a+}}[[X]]", Options());
+  ASSERT_TRUE(parsed.first);
+  VarMapping vars;
+  EXPECT_THAT(parsed.second[0].Search("aaa\n", vars), Eq(StringPiece::npos));
+  vars.Set(parsed.second[0].parts()[1].VarSlot(), "b");
+  EXPECT_THAT(parsed.second[0].Search("x\naab\n", vars), Eq(2u));
+}
+
 // Check::Part::Regex
 
 TEST(CheckPart, FixedPartRegex) {
@@ -15,8 +15,12 @@
 #ifndef EFFCEE_CURSOR_H
 #define EFFCEE_CURSOR_H
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "re2/stringpiece.h"
 
@@ -62,6 +66,25 @@ class Cursor {
     return *this;
   }
 
+  // Advances past every newline among the next |n| characters, counting
+  // lines.  This moves the cursor to the start of the line containing the
+  // character at offset |n|, unless that character is on the current line.
+  // Returns this object.
+  Cursor& AdvanceLinesBefore(size_t n) {
+    n = n < remaining_.size() ? n : remaining_.size();
+    const char* const end = remaining_.data() + n;
+    const char* line_start = remaining_.data();
+    const char* p = line_start;
+    while (p < end) {
+      p = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+      if (p == nullptr) break;
+      line_start = ++p;
+      ++line_num_;
+    }
+    remaining_.remove_prefix(size_t(line_start - remaining_.data()));
+    return *this;
+  }
+
  private:
   // The remaining text, after all previous advancements.  References the
   // original string storage.
@@ -70,29 +93,111 @@ class Cursor {
   int line_num_;
 };
 
-// Returns string containing a description of the line containing a given
-// subtext, with a message, and a caret displaying the subtext position.
-// Assumes subtext does not contain a newline.
-inline std::string LineMessage(StringPiece text, StringPiece subtext,
-                               StringPiece message) {
-  Cursor c(text);
-  StringPiece full_line = c.RestOfLine();
-  const auto* subtext_end = subtext.data() + subtext.size();
-  while (subtext_end - (full_line.data() + full_line.size()) > 0) {
-    c.AdvanceLine();
-    full_line = c.RestOfLine();
+// An index of the newlines in a text, for finding lines by position or by
+// number in logarithmic time.  The index is built on first use, with a
+// memchr scan.  It is safe to use from several threads at once.
+class LineIndex {
+ public:
+  explicit LineIndex(StringPiece text) : text_(text) {}
+
+  LineIndex(const LineIndex&) = delete;
+  LineIndex& operator=(const LineIndex&) = delete;
+
+  StringPiece text() const { return text_; }
+
+  // Returns the 1-based number of the line containing the character at
+  // |offset| in the text.  An offset at the end of the text is on the last
+  // line.
+  int LineNum(size_t offset) const {
+    const auto& newlines = Newlines();
+    return 1 + int(std::lower_bound(newlines.begin(), newlines.end(), offset) -
+                   newlines.begin());
+  }
+
+  // Returns the line with the given 1-based number, including its newline if
+  // it has one.  Returns an empty string if there is no such line.
+  StringPiece Line(int line_num) const {
+    const auto& newlines = Newlines();
+    if (line_num < 1 || size_t(line_num) > newlines.size() + 1) {
+      return StringPiece();
+    }
+    const size_t index = size_t(line_num - 1);
+    const size_t start = index == 0 ? 0 : newlines[index - 1] + 1;
+    const size_t end =
+        index < newlines.size() ? newlines[index] + 1 : text_.size();
+    return text_.substr(start, end - start);
   }
+
+  // Returns the 1-based number of the first line that ends at or after the
+  // end of |subtext|, where |subtext| is part of the text.  This is the line
+  // of the last character of a non-empty subtext.  An empty subtext at the
+  // start of a line is considered to be at the end of the previous line.
+  int LineNumOfEnd(StringPiece subtext) const {
+    const size_t end = size_t(subtext.data() + subtext.size() - text_.data());
+    if (end == 0) return 1;
+    // The line ending at the first newline at or after end - 1.
+    return LineNum(end - 1);
+  }
+
+ private:
+  // Returns the offsets of the newlines in the text, building the index if
+  // needed.
+  const std::vector<size_t>& Newlines() const {
+    std::call_once(built_, [this]() {
+      const char* const begin = text_.data();
+      const char* const end = begin + text_.size();
+      for (const char* p = begin; p < end; ++p) {
+        p = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (p == nullptr) break;
+        newlines_.push_back(size_t(p - begin));
+      }
+    });
+    return newlines_;
+  }
+
+  // The indexed text.
+  StringPiece text_;
+  // Guards building the index.
+  mutable std::once_flag built_;
+  // The offsets of the newlines in the text, in increasing order.
+  mutable std::vector<size_t> newlines_;
+};
+
+// Returns string containing a description of a position in a line, with
+// a message, and a caret displaying the position.  The position is at
+// 0-based |column| in |full_line|, which is line |line_num|.
+inline std::string LineMessage(int line_num, StringPiece full_line,
+                               size_t column, StringPiece message) {
   const char* full_line_newline =
       full_line.find('\n') == StringPiece::npos ? "\n" : "";
-  const auto column = size_t(subtext.data() - full_line.data());
 
   std::ostringstream out;
-  out << ":" << c.line_num() << ":" << (1 + column) << ": " << message << "\n"
+  out << ":" << line_num << ":" << (1 + column) << ": " << message << "\n"
       << full_line << full_line_newline << std::string(column, ' ') << "^\n";
 
   return out.str();
 }
 
+// Returns string containing a description of the line containing a given
+// subtext, with a message, and a caret displaying the subtext position.
+// Assumes subtext does not contain a newline.  The line is found with the
+// given index of the text containing the subtext.
+inline std::string LineMessage(const LineIndex& lines, StringPiece subtext,
+                               StringPiece message) {
+  const int line_num = lines.LineNumOfEnd(subtext);
+  const StringPiece full_line = lines.Line(line_num);
+  const auto column = size_t(subtext.data() - full_line.data());
+  return LineMessage(line_num, full_line, column, message);
+}
+
+// Returns string containing a description of the line containing a given
+// subtext, with a message, and a caret displaying the subtext position.
+// Assumes subtext does not contain a newline.
+inline std::string LineMessage(StringPiece text, StringPiece subtext,
+                               StringPiece message) {
+  return LineMessage(LineIndex(text), subtext, message);
+}
+
 }  // namespace effcee
 
 #endif
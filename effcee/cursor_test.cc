@@ -19,6 +19,7 @@
 namespace {
 
 using effcee::Cursor;
+using effcee::LineIndex;
 using effcee::LineMessage;
 using effcee::StringPiece;
 using ::testing::Eq;
@@ -119,6 +120,41 @@ TEST(Cursor, AdvanceLineWalksThroughTextByLineAndCountsLines) {
   EXPECT_THAT(c.remaining().data(), Eq(original + 25));
 }
 
+TEST(Cursor, AdvanceLinesBeforeReturnsTheCursorItself) {
+  Cursor c("foo\nbar");
+  EXPECT_THAT(&c.AdvanceLinesBefore(5), Eq(&c));
+}
+
+TEST(Cursor, AdvanceLinesBeforeStaysOnCurrentLine) {
+  const char* original = "The end\nOf an era";
+  Cursor c(original);
+  c.Advance(2).AdvanceLinesBefore(5);
+  EXPECT_THAT(c.line_num(), Eq(1));
+  EXPECT_THAT(c.remaining().data(), Eq(original + 2));
+}
+
+TEST(Cursor, AdvanceLinesBeforeCountsSkippedLines) {
+  const char* original = "The end\nOf an era\n\nIs here";
+  Cursor c(original);
+  c.Advance(2).AdvanceLinesBefore(20);
+  EXPECT_THAT(c.line_num(), Eq(4));
+  EXPECT_THAT(c.remaining(), Eq("Is here"));
+}
+
+TEST(Cursor, AdvanceLinesBeforeStopsAtLineStart) {
+  Cursor c("ab\ncd\nef");
+  c.AdvanceLinesBefore(3);
+  EXPECT_THAT(c.line_num(), Eq(2));
+  EXPECT_THAT(c.remaining(), Eq("cd\nef"));
+}
+
+TEST(Cursor, AdvanceLinesBeforeBeyondEndStopsAtLastLine) {
+  Cursor c("ab\ncd\nef");
+  c.AdvanceLinesBefore(100);
+  EXPECT_THAT(c.line_num(), Eq(3));
+  EXPECT_THAT(c.remaining(), Eq("ef"));
+}
+
 TEST(Cursor, AdvanceLineIsNoopAfterEndIsReached) {
   Cursor c("One\nTwo");
   c.AdvanceLine();
@@ -132,8 +168,70 @@ TEST(Cursor, AdvanceLineIsNoopAfterEndIsReached) {
   EXPECT_THAT(c.remaining(), Eq(""));
 }
 
+// LineIndex class
+
+TEST(LineIndex, LineNumOfEachCharacter) {
+  LineIndex lines("ab\n\ncd");
+  EXPECT_THAT(lines.LineNum(0), Eq(1));
+  EXPECT_THAT(lines.LineNum(1), Eq(1));
+  EXPECT_THAT(lines.LineNum(2), Eq(1));
+  EXPECT_THAT(lines.LineNum(3), Eq(2));
+  EXPECT_THAT(lines.LineNum(4), Eq(3));
+  EXPECT_THAT(lines.LineNum(5), Eq(3));
+  EXPECT_THAT(lines.LineNum(6), Eq(3));
+}
+
+TEST(LineIndex, LineNumOfEmptyText) {
+  LineIndex lines("");
+  EXPECT_THAT(lines.LineNum(0), Eq(1));
+}
+
+TEST(LineIndex, LinesIncludeTheirNewlines) {
+  LineIndex lines("ab\n\ncd");
+  EXPECT_THAT(lines.Line(1), Eq("ab\n"));
+  EXPECT_THAT(lines.Line(2), Eq("\n"));
+  EXPECT_THAT(lines.Line(3), Eq("cd"));
+}
+
+TEST(LineIndex, LineAfterFinalNewlineIsEmpty) {
+  LineIndex lines("ab\n");
+  EXPECT_THAT(lines.Line(1), Eq("ab\n"));
+  EXPECT_THAT(lines.Line(2), Eq(""));
+}
+
+TEST(LineIndex, LinesReferToText) {
+  const char* text = "ab\ncd";
+  LineIndex lines(text);
+  EXPECT_THAT(lines.Line(2).data(), Eq(text + 3));
+}
+
+TEST(LineIndex, LineOutOfRangeIsEmpty) {
+  LineIndex lines("ab\ncd");
+  EXPECT_THAT(lines.Line(0), Eq(""));
+  EXPECT_THAT(lines.Line(3), Eq(""));
+}
+
+TEST(LineIndex, LineNumOfEndOfSubtext) {
+  StringPiece text("ab\ncd");
+  LineIndex lines(text);
+  EXPECT_THAT(lines.LineNumOfEnd(text.substr(0, 0)), Eq(1));
+  EXPECT_THAT(lines.LineNumOfEnd(text.substr(1, 2)), Eq(1));
+  // An empty subtext at the start of a line belongs to the previous line.
+  EXPECT_THAT(lines.LineNumOfEnd(text.substr(3, 0)), Eq(1));
+  EXPECT_THAT(lines.LineNumOfEnd(text.substr(3, 1)), Eq(2));
+  EXPECT_THAT(lines.LineNumOfEnd(text.substr(6, 0)), Eq(2));
+}
+
 // LineMessage free function.
 
+TEST(LineMessage, UsesLineIndex) {
+  StringPiece text("Foo\nBar\nBaz");
+  LineIndex lines(text);
+  StringPiece subtext(text.data() + 9, 2);
+  EXPECT_THAT(LineMessage(lines, subtext, "loves quiche"),
+              Eq(":3:2: loves quiche\nBaz\n ^\n"));
+}
+
 TEST(LineMessage, SubtextIsFirst) {
   StringPiece text("Foo\nBar");
   StringPiece subtext(text.data(), 3);
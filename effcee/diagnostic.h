@@ -15,43 +15,105 @@
 #ifndef EFFCEE_DIAGNOSTIC_H
 #define EFFCEE_DIAGNOSTIC_H
 
+#include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "effcee/effcee.h"
+#include "effcee/make_unique.h"
 
 namespace effcee {
 
+// Notes describing the values of the variables used by a check, together
+// with those values.
+struct VariableNotes {
+  std::vector<Result::Note> notes;
+  std::vector<std::pair<std::string, std::string>> variables;
+};
+
 // A Diagnostic contains a Result::Status value and can accumulate message
 // values via operator<<.  It is convertible to a Result object containing the
 // status and the stringified message.
+//
+// Alternatively, a Diagnostic can accumulate a structured description of a
+// match failure from Result::Note and VariableNotes values.  The notes are
+// complete when added: they hold copies of the lines they describe, since the
+// result may outlive the input.  Only the message text is deferred: the
+// Result renders it from the description when it is first requested.
 class Diagnostic {
  public:
-  explicit Diagnostic(Result::Status status) : status_(status) {}
+  explicit Diagnostic(Result::Status status)
+      : status_(status), has_failure_(false) {}
+
+  // Constructs a diagnostic describing a match failure for the check rule
+  // at |check_index|, given the names of the input and of the check rules.
+  Diagnostic(Result::Status status, size_t check_index,
+             const std::string& input_name, const std::string& checks_name)
+      : status_(status), has_failure_(true) {
+    failure_.check_index = check_index;
+    failure_.input_name = input_name;
+    failure_.checks_name = checks_name;
+  }
 
   // Copy constructor.
-  Diagnostic(const Diagnostic& other) : status_(other.status_), message_() {
-    // We can't move an ostringstream.  As a fallback, we'd like to use the
-    // std::ostringstream(std::string init_string) constructor.  However, that
-    // initial string disappears inexplicably the first time we shift onto
-    // the |message_| member.  So fall back further and use the default
-    // constructor and later use an explicit shift.
-    message_ << other.message_.str();
+  Diagnostic(const Diagnostic& other)
+      : status_(other.status_),
+        has_failure_(other.has_failure_),
+        failure_(other.failure_) {
+    // We'd like to use the std::ostringstream(std::string init_string)
+    // constructor.  However, that initial string disappears inexplicably the
+    // first time we shift onto the stream.  So use the default constructor
+    // and an explicit shift.
+    if (other.message_) Message() << other.message_->str();
   }
 
   // Appends the given value to the accumulated message.
   template <typename T>
   Diagnostic& operator<<(const T& value) {
-    message_ << value;
+    Message() << value;
+    return *this;
+  }
+
+  // Appends a note to the failure description.
+  Diagnostic& operator<<(Result::Note note) {
+    failure_.notes.push_back(std::move(note));
     return *this;
   }
 
-  // Converts this object to a result value containing the stored status and a
-  // stringified copy of the message.
-  operator Result() const { return Result(status_, message_.str()); }
+  // Appends the notes and variable values to the failure description.
+  Diagnostic& operator<<(VariableNotes var_notes) {
+    for (auto& note : var_notes.notes) {
+      failure_.notes.push_back(std::move(note));
+    }
+    for (auto& variable : var_notes.variables) {
+      failure_.variables.push_back(std::move(variable));
+    }
+    return *this;
+  }
+
+  // Converts this object to a result value containing the stored status and
+  // either the failure description, or a stringified copy of the message.
+  operator Result() const {
+    if (has_failure_) return Result(status_, failure_);
+    return Result(status_, message_ ? message_->str() : std::string());
+  }
 
  private:
+  // Returns the stream accumulating the message, creating it on first use.
+  // A failure description never needs one.
+  std::ostringstream& Message() {
+    if (!message_) message_ = effcee::make_unique<std::ostringstream>();
+    return *message_;
+  }
+
   Result::Status status_;
-  std::ostringstream message_;
+  // The accumulated message, or null if nothing was appended.
+  std::unique_ptr<std::ostringstream> message_;
+  // True if this diagnostic describes a match failure in |failure_|.
+  bool has_failure_;
+  Result::Failure failure_;
 };
 
 }  // namespace effcee
@@ -15,7 +15,12 @@
 #ifndef EFFCEE_EFFCEE_H
 #define EFFCEE_EFFCEE_H
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "re2/re2.h"
 
 namespace effcee {
@@ -30,18 +35,101 @@ namespace effcee {
 
 using StringPiece = re2::StringPiece;
 
+// A span of time spent on one step of parsing or matching, for a timeline
+// of effcee's work.
+struct TraceEvent {
+  // What was done, for example "ParseChecks", and the phase it belongs to,
+  // either "parse" or "match".
+  std::string name;
+  std::string category;
+  // When the step started and ended.
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point end;
+  // Details of the step, as names and values.
+  std::vector<std::pair<std::string, std::string>> args;
+};
+
+// Receives the trace events of parses and matches using options that name
+// it.  See Options::SetTraceEventSink().
+class TraceEventSink {
+ public:
+  virtual ~TraceEventSink() = default;
+
+  // Records |event|.  This is called on the thread that did the work, and
+  // may be called from several threads at once.
+  virtual void Record(TraceEvent event) = 0;
+};
+
+// A trace event sink that collects events in memory, and writes them in
+// the Chrome trace-event JSON format, as loaded by chrome://tracing or
+// Perfetto.  Events are shown on a timeline for each thread that recorded
+// them.  It can be shared by several threads.
+class ChromeTraceSink : public TraceEventSink {
+ public:
+  ChromeTraceSink();
+  ~ChromeTraceSink() override;
+
+  void Record(TraceEvent event) override;
+
+  // Returns the events recorded so far, as a JSON object.  Times are in
+  // microseconds since this sink was made.
+  std::string ToJson() const;
+
+  // Writes ToJson() to the file at |path|.  Returns false if the file
+  // can't be written.
+  bool WriteFile(StringPiece path) const;
+
+ private:
+  // The recorded events, and the lock guarding them.
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// A request to stop matching, shared by the requester and the matches that
+// should stop.  It can be set from any thread.
+class CancellationToken {
+ public:
+  CancellationToken();
+  ~CancellationToken();
+
+  // Asks the matches using this token to stop.
+  void Cancel();
+  // Returns true if Cancel() has been called.
+  bool cancelled() const;
+
+ private:
+  // Holds the flag, which is set and read atomically.
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
 // Options for matching.
 class Options {
  public:
   Options()
-      : prefix_("CHECK"), input_name_("<stdin>"), checks_name_("<stdin>") {}
+      : prefixes_(1, "CHECK"), input_name_("<stdin>"),
+        checks_name_("<stdin>") {}
 
   // Sets rule prefix to a copy of |prefix|.  Returns this object.
   Options& SetPrefix(StringPiece prefix) {
-    prefix_ = std::string(prefix.begin(), prefix.end());
+    prefixes_.assign(1, std::string(prefix.begin(), prefix.end()));
     return *this;
   }
-  const std::string& prefix() const { return prefix_; }
+  // Returns the rule prefix, or the first of them if there are several.
+  const std::string& prefix() const { return prefixes_.front(); }
+
+  // Sets the rule prefixes to copies of |prefixes|.  Rules with any of the
+  // prefixes are recognized, in a single pass over the check list, and
+  // form one sequence of rules in the order they appear.  If several
+  // prefixes start a rule at the same position in a line, the earliest in
+  // |prefixes| is used.  An empty list is treated as a single empty prefix,
+  // which is invalid.  Returns this object.
+  Options& SetPrefixes(const std::vector<std::string>& prefixes) {
+    prefixes_ = prefixes;
+    if (prefixes_.empty()) prefixes_.emplace_back();
+    return *this;
+  }
+  const std::vector<std::string>& prefixes() const { return prefixes_; }
 
   // Sets the input name.  Returns this object.
   // Use this for file names, for example.
@@ -59,10 +147,127 @@ class Options {
   }
   const std::string& checks_name() const { return checks_name_; }
 
+  // Sets whether a successful match records where each check rule matched.
+  // Returns this object.  See Result::trace().
+  Options& SetTraceMatches(bool trace) {
+    trace_matches_ = trace;
+    return *this;
+  }
+  bool trace_matches() const { return trace_matches_; }
+
+  // Sets whether parsing and matching count the work they do, and time it.
+  // Returns this object.  See Result::stats().
+  Options& SetCollectStats(bool collect) {
+    collect_stats_ = collect;
+    return *this;
+  }
+  bool collect_stats() const { return collect_stats_; }
+
+  // Sets whether matching measures the cost of each check rule.  Returns
+  // this object.  See Result::profile().
+  Options& SetProfileChecks(bool profile) {
+    profile_checks_ = profile;
+    return *this;
+  }
+  bool profile_checks() const { return profile_checks_; }
+
+  // Sets the sink that receives trace events for the parse, for regex
+  // compilation, for each resolved check rule, for the windows of DAG and
+  // NOT rules, and for failure descriptions.  If |sink| is null, no events
+  // are made.  The sink is shared by copies of these options.  Returns this
+  // object.
+  Options& SetTraceEventSink(std::shared_ptr<TraceEventSink> sink) {
+    trace_event_sink_ = std::move(sink);
+    return *this;
+  }
+  TraceEventSink* trace_event_sink() const { return trace_event_sink_.get(); }
+
+  // Sets the most memory, in bytes, that RE2 may use for the regex of each
+  // check rule.  A rule whose regex needs more can't be parsed, and the
+  // result has status ResourceExhausted.  When matching, a regex that runs
+  // out of memory falls back to a slower search.  If |bytes| is 0, RE2's
+  // default is used.  Returns this object.
+  Options& SetRegexMaxMem(int64_t bytes) {
+    regex_max_mem_ = bytes;
+    return *this;
+  }
+  int64_t regex_max_mem() const { return regex_max_mem_; }
+
+  // Sets the most input a match may scan, in bytes.  Each byte counts each
+  // time a check rule is tried against it.  A match that would scan more
+  // stops, and its result has status ResourceExhausted.  If |bytes| is 0,
+  // there is no limit.  Returns this object.
+  Options& SetScanBudget(size_t bytes) {
+    scan_budget_ = bytes;
+    return *this;
+  }
+  size_t scan_budget() const { return scan_budget_; }
+
+  // Sets the time by which a match must end.  A match still running then
+  // stops soon after, and its result has status Cancelled.  The default is
+  // no deadline.  Returns this object.
+  Options& SetDeadline(std::chrono::steady_clock::time_point deadline) {
+    deadline_ = deadline;
+    return *this;
+  }
+  std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+  bool has_deadline() const {
+    return deadline_ != std::chrono::steady_clock::time_point::max();
+  }
+
+  // Sets the token that can ask a match to stop.  A match using these
+  // options checks the token now and then, and once it is cancelled stops
+  // with status Cancelled.  If |token| is null, matches can't be cancelled
+  // this way.  Returns this object.
+  Options& SetCancellationToken(
+      std::shared_ptr<const CancellationToken> token) {
+    cancellation_token_ = std::move(token);
+    return *this;
+  }
+  const CancellationToken* cancellation_token() const {
+    return cancellation_token_.get();
+  }
+
  private:
-  std::string prefix_;
+  // The rule prefixes.  There is always at least one.
+  std::vector<std::string> prefixes_;
   std::string input_name_;
   std::string checks_name_;
+  bool trace_matches_ = false;
+  bool collect_stats_ = false;
+  bool profile_checks_ = false;
+  std::shared_ptr<TraceEventSink> trace_event_sink_;
+  int64_t regex_max_mem_ = 0;
+  size_t scan_budget_ = 0;
+  std::chrono::steady_clock::time_point deadline_ =
+      std::chrono::steady_clock::time_point::max();
+  std::shared_ptr<const CancellationToken> cancellation_token_;
+};
+
+// Counts of the work done to parse check rules and match them against an
+// input, and the time it took.  See Options::SetCollectStats().
+struct MatchStats {
+  // The number of regexes compiled, while parsing and while matching.  A
+  // check that uses variables compiles its regex for each attempt.
+  size_t regexes_compiled = 0;
+  // The number of times a regex or a set of regexes was run against text.
+  size_t regex_matches = 0;
+  // The number of input lines tried against the checks, and their total
+  // size in bytes.  Lines skipped without trying a check are not counted.
+  size_t lines_scanned = 0;
+  size_t bytes_scanned = 0;
+  // The number of DAG and NOT checks tried in passes over the window of
+  // unresolved checks, and the most tried in a single pass.
+  size_t window_checks = 0;
+  size_t max_window_checks = 0;
+  // The number of variable definitions matched.
+  size_t var_definitions = 0;
+  // Seconds spent parsing the check rules, matching the input, and
+  // describing a match failure.  The match time includes the failure
+  // description.
+  double parse_seconds = 0;
+  double match_seconds = 0;
+  double diagnostic_seconds = 0;
 };
 
 // The result of an attempted match.
@@ -70,37 +275,260 @@ class Result {
  public:
   enum class Status {
     Ok = 0,
-    Fail,       // A failure to match
-    BadOption,  // A bad option was specified
-    NoRules,    // No rules were specified
-    BadRule,    // A bad rule was specified
+    Fail,               // A failure to match
+    BadOption,          // A bad option was specified
+    NoRules,            // No rules were specified
+    BadRule,            // A bad rule was specified
+    BadFile,            // A file could not be read
+    ResourceExhausted,  // A memory or scan limit was exceeded
+    Cancelled,          // The match was cancelled, or its deadline passed
+  };
+
+  // A note in the description of a match failure.  It points at a position
+  // in the input or in the check rules.
+  struct Note {
+    // The text containing the position.
+    enum class Source { Input, Checks };
+    Source source;
+    // The byte offset of the position from the start of its text.
+    size_t offset;
+    // The 1-based line and column of the position.
+    int line_num;
+    int column;
+    // A copy of the line containing the position, including its newline if
+    // it has one.
+    std::string line;
+    // What is noted, for example "note: scanning from here".
+    std::string message;
+  };
+
+  // The description of a match failure.
+  struct Failure {
+    // The index of the check rule that could not be satisfied, counting
+    // only check rules.
+    size_t check_index;
+    // The names of the input and of the check rules, from the Options.
+    std::string input_name;
+    std::string checks_name;
+    // The notes, in the order they appear in the message.
+    std::vector<Note> notes;
+    // The variables used by the check rule, with their values at the time
+    // of failure.  Undefined variables are omitted.
+    std::vector<std::pair<std::string, std::string>> variables;
+  };
+
+  // A variable definition matched by a check rule.
+  struct Capture {
+    // The name of the variable.
+    std::string name;
+    // The matched value.  It refers to the input text.
+    StringPiece value;
+    // The byte offset of the value from the start of the input.
+    size_t offset;
+  };
+
+  // Where a check rule matched the input.
+  struct CheckMatch {
+    // True if the check rule matched.  A CHECK-NOT rule is resolved without
+    // matching, so this is false for it.
+    bool matched;
+    // The matched text.  It refers to the input text.
+    StringPiece text;
+    // The byte offset of the matched text from the start of the input.
+    size_t offset;
+    // The 1-based line number of the start of the matched text.
+    int line_num;
+    // The variables defined by the match, in the order they appear in the
+    // check rule.
+    std::vector<Capture> captures;
+  };
+
+  // The cost of matching one check rule.
+  struct CheckProfile {
+    // The index of the check rule, counting only check rules.
+    size_t check_index;
+    // The 1-based line and column of the rule's parameter in the check
+    // rules.
+    int line_num;
+    int column;
+    // A copy of the line holding the rule, without its line ending.
+    std::string rule;
+    // The number of times the rule was tried against the rest of a line.
+    size_t lines_probed;
+    // The number of those times it was not ruled out by a prefilter, and
+    // its pattern was matched.
+    size_t match_attempts;
+    // The number of times a regex or a set of regexes was run for the rule.
+    size_t regex_matches;
+    // The time spent trying the rule, in seconds.
+    double seconds;
   };
 
   // Constructs a result with a given status.
-  explicit Result(Status status) : status_(status) {}
+  explicit Result(Status status) : status_(status), render_failure_(false) {}
   // Constructs a result with the given message.  Keeps a copy of the message.
   Result(Status status, StringPiece message)
-      : status_(status), message_({message.begin(), message.end()}) {}
+      : status_(status),
+        message_({message.begin(), message.end()}),
+        render_failure_(false) {}
+  // Constructs a result describing a match failure.  The message is only
+  // rendered from |failure| when it is first requested.
+  Result(Status status, Failure failure);
 
   Status status() const { return status_; }
 
   // Returns true if the match was successful.
   operator bool() const { return status_ == Status::Ok; }
 
-  const std::string& message() const { return message_; }
+  // Returns the message.  It may be rendered on this call.
+  const std::string& message() const;
+
+  // Returns the description of the match failure, if there is one.
+  // Otherwise returns null.
+  const Failure* failure() const;
 
   // Sets the error message to a copy of |message|.  Returns this object.
   Result& SetMessage(StringPiece message) {
     message_ = std::string(message.begin(), message.end());
+    render_failure_ = false;
+    return *this;
+  }
+
+  // Returns the match trace.  When Options::SetTraceMatches(true) was used,
+  // a successful match has one entry for each check rule, in order.
+  // Otherwise the trace is empty.  The entries refer to the input text, so
+  // they are only valid while it is.
+  const std::vector<CheckMatch>& trace() const { return trace_; }
+
+  // Sets the match trace.  Returns this object.
+  Result& SetTrace(std::vector<CheckMatch> trace) {
+    trace_ = std::move(trace);
+    return *this;
+  }
+
+  // Returns the statistics of the parse and match, if they were collected
+  // because Options::SetCollectStats(true) was used.  Otherwise returns
+  // null.
+  const MatchStats* stats() const { return stats_.get(); }
+
+  // Returns the cost of each check rule, in order, if
+  // Options::SetProfileChecks(true) was used and the check rules were
+  // parsed successfully.  Otherwise the profile is empty.
+  const std::vector<CheckProfile>& profile() const { return profile_; }
+
+  // Sets the check rule profile.  Returns this object.
+  Result& SetProfile(std::vector<CheckProfile> profile) {
+    profile_ = std::move(profile);
+    return *this;
+  }
+
+  // Returns a report of the |top_n| check rules that took the longest, most
+  // expensive first, with one line per rule.  Returns an empty string if
+  // the profile is empty.
+  std::string ProfileReport(size_t top_n = 10) const;
+
+  // Sets the statistics to a copy of |stats|.  Returns this object.
+  Result& SetStats(const MatchStats& stats) {
+    stats_ = std::make_shared<const MatchStats>(stats);
     return *this;
   }
 
  private:
+  // A failure description and its rendered message.
+  class FailureDetail;
+
   // Status code indicating success, or kind of failure.
   Status status_;
 
   // Message describing the failure, if any.  On success, this is empty.
+  // Unused when the message is rendered from |failure_|.
   std::string message_;
+
+  // The match failure, if any.  It is shared by copies of this result.
+  std::shared_ptr<const FailureDetail> failure_;
+
+  // True if the message is rendered from |failure_|.
+  bool render_failure_;
+
+  // Where each check rule matched, if the match was traced.
+  std::vector<CheckMatch> trace_;
+
+  // The statistics, if they were collected.  They are shared by copies of
+  // this result.
+  std::shared_ptr<const MatchStats> stats_;
+
+  // The cost of each check rule, if the match was profiled.
+  std::vector<CheckProfile> profile_;
+};
+
+// A check program: a list of check rules parsed once, and then matched
+// against any number of inputs.  A Program keeps its own copy of the check
+// rules, so the original storage need not outlive it.  Copies of a Program
+// share the same parsed rules.  A Program can be used to match from several
+// threads at once.
+class Program {
+ public:
+  // Parses the check rules in |checks|, taking |options| into account.
+  // Keeps a copy of |checks| and |options|.  Use compile_result() to find
+  // out if the rules were valid.
+  explicit Program(StringPiece checks, const Options& options = Options());
+
+  // Returns the result of parsing the check rules.  On success, the status
+  // is Result::Status::Ok.
+  const Result& compile_result() const;
+
+  // Returns true if the check rules were parsed successfully.
+  operator bool() const { return compile_result(); }
+
+  // Returns the result of attempting to match |text| against this program.
+  // If the check rules were not parsed successfully, then returns the
+  // parse result.
+  Result Match(StringPiece text) const;
+
+  // Returns the result of attempting to match the contents of the file at
+  // |input_path| against this program.  A regular file is memory-mapped
+  // rather than copied, and anything else, such as a pipe, is read in
+  // chunks.  Unless an input name was set in the options, diagnostics name
+  // the input by its path.  The match is not traced.  If the file can't be
+  // read, the result has status BadFile.
+  Result MatchFile(StringPiece input_path) const;
+
+  // The internal representation of the program.
+  class Impl;
+
+ private:
+  friend class StreamingMatcher;
+
+  std::shared_ptr<const Impl> impl_;
+};
+
+// Matches a program against an input that arrives in chunks, for example
+// as it is read from a pipe.  The whole input is not kept in memory: only
+// the incomplete last line seen so far, and copies of the lines needed to
+// describe a failure.  The result is the same as for Program::Match on the
+// concatenated chunks, except that the match is not traced.
+class StreamingMatcher {
+ public:
+  // Starts a match against |program|.
+  explicit StreamingMatcher(const Program& program);
+  ~StreamingMatcher();
+
+  StreamingMatcher(StreamingMatcher&&);
+  StreamingMatcher& operator=(StreamingMatcher&&);
+
+  // Matches the complete lines of the input that |chunk| completes.  The
+  // chunk is not used after this call returns.  Returns false if the outcome
+  // of the match has been decided, for example because a CHECK-NOT rule
+  // matched.  In that case later chunks are ignored.
+  bool Feed(StringPiece chunk);
+
+  // Matches the rest of the input, and returns the result of the match.
+  // Call this once, after the last chunk.
+  Result Finish();
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
 };
 
 // Returns the result of attempting to match |text| against the pattern
@@ -108,6 +536,24 @@ class Result {
 Result Match(StringPiece text, StringPiece checks,
              const Options& options = Options());
 
+// Returns the results of attempting to match each of |inputs| against
+// |program|, in the same order as the inputs.  The inputs are shared out
+// among |num_threads| threads, each taking the next unmatched input when it
+// finishes one.  If |num_threads| is 0, one thread is used for each
+// processor.  The program is parsed only once, and is shared by the
+// threads.  The inputs are given as a vector because std::span needs
+// C++20, and Effcee builds as C++17.
+std::vector<Result> MatchBatch(const Program& program,
+                               const std::vector<StringPiece>& inputs,
+                               unsigned num_threads = 0);
+
+// Returns the result of attempting to match the contents of the file at
+// |input_path| against the check rules in the file at |checks_path|, with
+// the given |options|.  Unless their names were set in the options,
+// diagnostics name the files by their paths.  See Program::MatchFile.
+Result MatchFile(StringPiece input_path, StringPiece checks_path,
+                 const Options& options = Options());
+
 }  // namespace effcee
 
 #endif
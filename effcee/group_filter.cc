@@ -0,0 +1,129 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "group_filter.h"
+
+#include <string>
+#include <utility>
+
+#include "make_unique.h"
+
+namespace {
+
+using effcee::Check;
+
+// Returns true if |check| is worth putting in a set.  Its regex must not
+// depend on variable values.  A check that is a single fixed string is
+// already matched quickly without RE2.
+bool BelongsInSet(const Check& check) {
+  if (check.type() != Check::Type::DAG && check.type() != Check::Type::Not) {
+    return false;
+  }
+  const auto& parts = check.parts();
+  if (parts.empty()) return false;
+  if (parts.size() == 1 && parts[0].type() == Check::Part::Type::Fixed) {
+    return false;
+  }
+  for (const auto& part : parts) {
+    if (!part.VarUseName().empty()) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace effcee {
+
+GroupFilter::GroupFilter(const CheckList& checks, int64_t regex_max_mem)
+    : group_of_check_(checks.size(), -1), member_of_check_(checks.size(), -1) {
+  const VarMapping no_vars;
+  RE2::Options set_options;
+  if (regex_max_mem > 0) set_options.set_max_mem(regex_max_mem);
+  size_t i = 0;
+  while (i < checks.size()) {
+    // Find the next group.
+    const auto is_dag_or_not = [&checks](size_t j) {
+      return checks[j].type() == Check::Type::DAG ||
+             checks[j].type() == Check::Type::Not;
+    };
+    if (!is_dag_or_not(i)) {
+      ++i;
+      continue;
+    }
+    size_t end = i;
+    while (end < checks.size() && is_dag_or_not(end)) ++end;
+
+    std::vector<size_t> members;
+    for (size_t j = i; j < end; ++j) {
+      if (BelongsInSet(checks[j])) members.push_back(j);
+    }
+    // A set only saves work when it replaces several scans.
+    if (members.size() > 1) {
+      auto set = effcee::make_unique<RE2::Set>(set_options, RE2::UNANCHORED);
+      std::vector<size_t> added;
+      for (size_t j : members) {
+        std::string pattern;
+        for (const auto& part : checks[j].parts()) {
+          pattern += part.Regex(no_vars);
+        }
+        std::string error;
+        if (set->Add(pattern, &error) >= 0) added.push_back(j);
+      }
+      if (added.size() > 1 && set->Compile()) {
+        const int group_index = static_cast<int>(groups_.size());
+        for (size_t k = 0; k < added.size(); ++k) {
+          group_of_check_[added[k]] = group_index;
+          member_of_check_[added[k]] = static_cast<int>(k);
+        }
+        groups_.push_back(Group{std::move(set), added.size()});
+      }
+    }
+    i = end;
+  }
+}
+
+GroupFilter::GroupFilter(size_t num_checks)
+    : group_of_check_(num_checks, -1), member_of_check_(num_checks, -1) {}
+
+GroupFilter::Scanner::Scanner(const GroupFilter& filter, MatchStats* stats)
+    : filter_(filter), stats_(stats), scans_(filter.groups_.size()) {}
+
+bool GroupFilter::Scanner::MightMatch(size_t i, StringPiece text) {
+  const int group_index = filter_.group_of_check_[i];
+  if (group_index < 0) return true;
+  const Group& group = filter_.groups_[group_index];
+  Scan& scan = scans_[group_index];
+  if (scan.text.data() != text.data() || scan.text.size() != text.size() ||
+      scan.might_match.empty()) {
+    scan.text = text;
+    RE2::Set::ErrorInfo error_info;
+    if (stats_) ++stats_->regex_matches;
+    if (group.set->Match(text, &hits_, &error_info)) {
+      scan.might_match.assign(group.num_members, false);
+      for (int hit : hits_) scan.might_match[hit] = true;
+    } else {
+      // Either nothing matched, or the set could not decide.  In the
+      // second case, every check must be tried.
+      const bool undecided = error_info.kind != RE2::Set::kNoError;
+      scan.might_match.assign(group.num_members, undecided);
+    }
+  }
+  return scan.might_match[filter_.member_of_check_[i]];
+}
+
+void GroupFilter::Scanner::Forget() {
+  for (auto& scan : scans_) scan.might_match.clear();
+}
+
+}  // namespace effcee
@@ -0,0 +1,99 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_GROUP_FILTER_H
+#define EFFCEE_GROUP_FILTER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "check.h"
+#include "re2/set.h"
+
+namespace effcee {
+
+// Quickly rules out DAG and NOT checks that can't match a piece of text.
+//
+// A group is a maximal run of consecutive DAG and NOT checks in a check list.
+// While matching, the unresolved checks of a group are tried against the
+// same text, one after the other.  The regex checks without variable uses in
+// a group are combined into an RE2::Set, which finds the ones that might
+// match the text in a single scan.  Only those need to be tried individually.
+class GroupFilter {
+ public:
+  // Builds the filter for the given checks.  If |regex_max_mem| is
+  // positive, it is the most memory in bytes that RE2 may use for each set.
+  // A set that needs more is not used.
+  explicit GroupFilter(const CheckList& checks, int64_t regex_max_mem = 0);
+  // Builds a filter without sets for |num_checks| checks.  It rules out
+  // nothing.
+  explicit GroupFilter(size_t num_checks);
+
+  GroupFilter(const GroupFilter&) = delete;
+  GroupFilter& operator=(const GroupFilter&) = delete;
+
+  // Returns the number of groups having a set.
+  size_t num_sets() const { return groups_.size(); }
+
+  // Per-match state.  It remembers the result of the most recent scan for
+  // each group, so a group's set is run at most once per piece of text.
+  class Scanner {
+   public:
+    // If |stats| is not null, each run of a set is counted in it.
+    explicit Scanner(const GroupFilter& filter, MatchStats* stats = nullptr);
+
+    // Returns false if check |i| certainly does not match |text|, where
+    // |i| is an index into the check list used to build the filter.  A true
+    // result means the check might match.
+    bool MightMatch(size_t i, StringPiece text);
+
+    // Forgets the remembered scans.  Call this before scanning text that
+    // may reuse the storage of text scanned earlier.
+    void Forget();
+
+   private:
+    // The most recent scan of a group's set.
+    struct Scan {
+      // The scanned text.  Its data is null before the first scan.
+      StringPiece text;
+      // Indexed by set member.  True if that member might match the text.
+      std::vector<bool> might_match;
+    };
+
+    const GroupFilter& filter_;
+    MatchStats* stats_;
+    std::vector<Scan> scans_;
+    // Scratch storage for set matches.
+    std::vector<int> hits_;
+  };
+
+ private:
+  struct Group {
+    std::unique_ptr<RE2::Set> set;
+    size_t num_members;
+  };
+
+  // The groups having a set.
+  std::vector<Group> groups_;
+  // For each check, the index of its group in |groups_|, or -1 if the check
+  // is not in a set.
+  std::vector<int> group_of_check_;
+  // For each check in a set, its index in that set.
+  std::vector<int> member_of_check_;
+};
+
+}  // namespace effcee
+
+#endif
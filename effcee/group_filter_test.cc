@@ -0,0 +1,109 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+
+#include "gmock/gmock.h"
+
+#include "check.h"
+#include "group_filter.h"
+
+namespace {
+
+using effcee::CheckList;
+using effcee::GroupFilter;
+using effcee::Options;
+using effcee::ParseChecks;
+using ::testing::Eq;
+
+// Returns the checks parsed from |text|, which must be valid.
+CheckList Parse(const char* text) {
+  auto parsed = ParseChecks(text, Options());
+  EXPECT_TRUE(parsed.first) << parsed.first.message();
+  return std::move(parsed.second);
+}
+
+TEST(GroupFilter, NoSetsWithoutDAGOrNot) {
+  const auto checks = Parse("CHECK: {{a+}}\nCHECK-NEXT: {{b+}}");
+  GroupFilter filter(checks);
+  EXPECT_THAT(filter.num_sets(), Eq(0u));
+  GroupFilter::Scanner scanner(filter);
+  EXPECT_TRUE(scanner.MightMatch(0, "zzz"));
+  EXPECT_TRUE(scanner.MightMatch(1, "zzz"));
+}
+
+TEST(GroupFilter, FilterWithoutSetsRulesOutNothing) {
+  GroupFilter filter(2);
+  EXPECT_THAT(filter.num_sets(), Eq(0u));
+  GroupFilter::Scanner scanner(filter);
+  EXPECT_TRUE(scanner.MightMatch(0, "zzz"));
+  EXPECT_TRUE(scanner.MightMatch(1, "zzz"));
+}
+
+TEST(GroupFilter, NoSetForSingleRegexCheck) {
+  const auto checks = Parse("CHECK-DAG: {{a+}}\nCHECK: x");
+  GroupFilter filter(checks);
+  EXPECT_THAT(filter.num_sets(), Eq(0u));
+}
+
+TEST(GroupFilter, NoSetForLiteralChecks) {
+  const auto checks = Parse("CHECK-DAG: a\nCHECK-DAG: b\nCHECK-NOT: c");
+  GroupFilter filter(checks);
+  EXPECT_THAT(filter.num_sets(), Eq(0u));
+}
+
+TEST(GroupFilter, NoSetForChecksUsingVariables) {
+  const auto checks = Parse(
+      "CHECK: [[X:.]]\nCHECK-DAG: a[[X]]{{.}}\nCHECK-DAG: b[[X]]{{.}}");
+  GroupFilter filter(checks);
+  EXPECT_THAT(filter.num_sets(), Eq(0u));
+}
+
+TEST(GroupFilter, OneSetPerGroup) {
+  const auto checks = Parse(
+      "CHECK-DAG: {{a+}}\nCHECK-NOT: {{b+}}\nCHECK: x\n"
+      "CHECK-DAG: {{c+}}\nCHECK-DAG: {{d+}}");
+  GroupFilter filter(checks);
+  EXPECT_THAT(filter.num_sets(), Eq(2u));
+}
+
+TEST(GroupFilter, ScannerFindsPossibleMatches) {
+  const auto checks = Parse(
+      "CHECK-DAG: x{{a+}}\nCHECK-NOT: {{b+}}y\nCHECK-DAG: lit\n"
+      "CHECK-DAG: [[V:c+]]");
+  GroupFilter filter(checks);
+  ASSERT_THAT(filter.num_sets(), Eq(1u));
+  GroupFilter::Scanner scanner(filter);
+  const effcee::StringPiece line = "xaa cc";
+  EXPECT_TRUE(scanner.MightMatch(0, line));
+  EXPECT_FALSE(scanner.MightMatch(1, line));
+  // Checks outside the set always might match.
+  EXPECT_TRUE(scanner.MightMatch(2, line));
+  EXPECT_TRUE(scanner.MightMatch(3, line));
+}
+
+TEST(GroupFilter, ScannerRescansNewText) {
+  const auto checks = Parse("CHECK-DAG: {{a+}}\nCHECK-DAG: {{b+}}");
+  GroupFilter filter(checks);
+  GroupFilter::Scanner scanner(filter);
+  const std::string text = "aaa bbb";
+  const effcee::StringPiece whole(text);
+  EXPECT_TRUE(scanner.MightMatch(0, whole));
+  EXPECT_TRUE(scanner.MightMatch(1, whole));
+  EXPECT_FALSE(scanner.MightMatch(0, whole.substr(3)));
+  EXPECT_TRUE(scanner.MightMatch(1, whole.substr(3)));
+  EXPECT_FALSE(scanner.MightMatch(1, whole.substr(0, 3)));
+}
+
+}  // namespace
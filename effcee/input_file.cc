@@ -0,0 +1,107 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "input_file.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "effcee.h"
+
+namespace effcee {
+
+namespace {
+
+// The size of the chunks read from a file that is not mapped.
+const size_t kChunkSize = 1 << 16;
+
+// Returns a BadFile result describing a failure to |action| the file at
+// |path|, given the error number.
+Result FileError(const char* action, const std::string& path, int error) {
+  return Result(Result::Status::BadFile, std::string("error: cannot ") +
+                                             action + " " + path + ": " +
+                                             std::strerror(error));
+}
+
+}  // namespace
+
+InputFile::InputFile() : file_(nullptr), mapping_(nullptr), mapping_size_(0) {}
+
+InputFile::~InputFile() {
+#if !defined(_WIN32)
+  if (mapping_) munmap(mapping_, mapping_size_);
+#endif
+  if (file_) std::fclose(file_);
+}
+
+Result InputFile::Open(const std::string& path) {
+  path_ = path;
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) return FileError("open", path, errno);
+  return Result(Result::Status::Ok);
+}
+
+bool InputFile::Map(StringPiece* contents) {
+#if defined(_WIN32)
+  (void)contents;
+  return false;
+#else
+  if (!file_) return false;
+  struct stat info;
+  const int fd = fileno(file_);
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) return false;
+  const size_t size = size_t(info.st_size);
+  if (size == 0) {
+    // An empty file can't be mapped, but its contents are known.
+    *contents = StringPiece("", 0);
+    return true;
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) return false;
+  mapping_ = mapping;
+  mapping_size_ = size;
+  *contents = StringPiece(static_cast<const char*>(mapping), size);
+  return true;
+#endif
+}
+
+Result InputFile::Read(StringPiece* chunk) {
+  buffer_.resize(kChunkSize);
+  const size_t size = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+  if (size == 0 && std::ferror(file_)) return FileError("read", path_, errno);
+  *chunk = StringPiece(buffer_.data(), size);
+  return Result(Result::Status::Ok);
+}
+
+Result InputFile::ReadAll(std::string* storage, StringPiece* contents) {
+  if (Map(contents)) return Result(Result::Status::Ok);
+  storage->clear();
+  StringPiece chunk;
+  do {
+    const Result result = Read(&chunk);
+    if (!result) return result;
+    storage->append(chunk.data(), chunk.size());
+  } while (!chunk.empty());
+  *contents = *storage;
+  return Result(Result::Status::Ok);
+}
+
+}  // namespace effcee
@@ -0,0 +1,70 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_INPUT_FILE_H
+#define EFFCEE_INPUT_FILE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "effcee.h"
+
+namespace effcee {
+
+// A file opened for reading.  A regular file can be memory-mapped, so its
+// contents are used without copying them.  Other files, such as pipes, are
+// read in chunks.
+class InputFile {
+ public:
+  InputFile();
+  ~InputFile();
+
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+
+  // Opens the file at |path|.  On failure returns a result with status
+  // BadFile.
+  Result Open(const std::string& path);
+
+  // Maps the whole file into memory, read-only, and points |contents| at
+  // it.  The mapping lasts until this object is destroyed.  Returns false
+  // if the file can't be mapped, for example because it is a pipe.  Then
+  // the file may still be read with Read().
+  bool Map(StringPiece* contents);
+
+  // Reads the next chunk of the file, and points |chunk| at it.  The chunk
+  // is valid until the next call.  At the end of the file the chunk is
+  // empty.  On failure returns a result with status BadFile.
+  Result Read(StringPiece* chunk);
+
+  // Points |contents| at the whole contents of the file.  That is the
+  // mapping if the file can be mapped, and otherwise a copy read into
+  // |storage|.  On failure returns a result with status BadFile.
+  Result ReadAll(std::string* storage, StringPiece* contents);
+
+ private:
+  // The path of the open file.
+  std::string path_;
+  std::FILE* file_;
+  // The mapped contents, if the file is mapped.
+  void* mapping_;
+  size_t mapping_size_;
+  // Holds the most recent chunk read.
+  std::vector<char> buffer_;
+};
+
+}  // namespace effcee
+
+#endif
@@ -0,0 +1,97 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <string>
+
+#include "gmock/gmock.h"
+
+#include "input_file.h"
+
+namespace {
+
+using effcee::InputFile;
+using effcee::StringPiece;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+using Status = effcee::Result::Status;
+
+// Writes |contents| to a new temporary file, and returns its path.
+std::string WriteTempFile(const std::string& name,
+                          const std::string& contents) {
+  const std::string path = ::testing::TempDir() + name;
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  std::fwrite(contents.data(), 1, contents.size(), file);
+  std::fclose(file);
+  return path;
+}
+
+// InputFile class
+
+TEST(InputFile, OpenMissingFileFails) {
+  InputFile file;
+  const auto result = file.Open(::testing::TempDir() + "no-such-file");
+  EXPECT_THAT(result.status(), Eq(Status::BadFile));
+  EXPECT_THAT(result.message(), HasSubstr("error: cannot open"));
+  EXPECT_THAT(result.message(), HasSubstr("no-such-file"));
+}
+
+TEST(InputFile, MapRegularFile) {
+  const std::string path = WriteTempFile("map.txt", "Hello\nWorld\n");
+  InputFile file;
+  ASSERT_TRUE(file.Open(path));
+  StringPiece contents;
+  ASSERT_TRUE(file.Map(&contents));
+  EXPECT_THAT(contents, Eq("Hello\nWorld\n"));
+  std::remove(path.c_str());
+}
+
+TEST(InputFile, MapEmptyFile) {
+  const std::string path = WriteTempFile("empty.txt", "");
+  InputFile file;
+  ASSERT_TRUE(file.Open(path));
+  StringPiece contents("not empty");
+  ASSERT_TRUE(file.Map(&contents));
+  EXPECT_THAT(contents, Eq(""));
+  std::remove(path.c_str());
+}
+
+TEST(InputFile, ReadInChunks) {
+  const std::string text(100000, 'x');
+  const std::string path = WriteTempFile("read.txt", text);
+  InputFile file;
+  ASSERT_TRUE(file.Open(path));
+  std::string contents;
+  StringPiece chunk;
+  do {
+    ASSERT_TRUE(file.Read(&chunk));
+    contents.append(chunk.data(), chunk.size());
+  } while (!chunk.empty());
+  EXPECT_THAT(contents, Eq(text));
+  std::remove(path.c_str());
+}
+
+TEST(InputFile, ReadAll) {
+  const std::string path = WriteTempFile("all.txt", "abc");
+  InputFile file;
+  ASSERT_TRUE(file.Open(path));
+  std::string storage;
+  StringPiece contents;
+  ASSERT_TRUE(file.ReadAll(&storage, &contents));
+  EXPECT_THAT(contents, Eq("abc"));
+  std::remove(path.c_str());
+}
+
+}  // namespace
@@ -13,253 +13,159 @@
 // limitations under the License.
 
 #include <algorithm>
-#include <cassert>
-#include <sstream>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
-#include "check.h"
-#include "cursor.h"
-#include "diagnostic.h"
 #include "effcee.h"
+#include "input_file.h"
+#include "make_unique.h"
+#include "matcher.h"
+#include "program.h"
 #include "to_string.h"
 
-using effcee::Check;
-using Status = effcee::Result::Status;
-using Type = effcee::Check::Type;
-
 namespace effcee {
 
-Result Match(StringPiece input, StringPiece checks, const Options& options) {
-  const auto& parse_result = ParseChecks(checks, options);
-  if (!parse_result.first) return parse_result.first;
-
-  // A mapping from variable names to values.  This is updated when a check rule
-  // matches a variable definition.
-  VarMapping vars;
-
-  // We think of the input string as a sequence of lines that can satisfy
-  // the checks.  Walk through the rules until no unsatisfied checks are left.
-  // We will erase a check when it has been satisifed.
-  const CheckList& pattern = parse_result.second;
-  assert(pattern.size() > 0);
-
-  // What checks are resolved?  Entry |i| is true when check |i| in the
-  // pattern is resolved.
-  std::vector<bool> resolved(pattern.size(), false);
+class CancellationToken::Impl {
+ public:
+  std::atomic<bool> cancelled{false};
+};
 
-  // The matching algorithm scans both the input and the pattern from start
-  // to finish.  At the start, all checks are unresolved.  We try to match
-  // each line in the input against the unresolved checks in a sliding window
-  // in the pattern.  When a positive check matches, we mark it as resolved.
-  // When a negative check matches, the algorithm terminates with failure.
-  // We mark a negative check as resolved when it is the earliest unresolved
-  // check and the first positive check after it is resolved.
+CancellationToken::CancellationToken() : impl_(effcee::make_unique<Impl>()) {}
 
-  // Initially the pattern window is just the first element.
-  // |first_check| is the first unresolved check.
-  size_t first_check = 0;
-  const size_t num_checks = pattern.size();
+CancellationToken::~CancellationToken() = default;
 
-  // The 1-based line number of the most recent successful match.
-  int matched_line_num = 0;
-
-  // Set up a cursor to scan the input, and helpers for generating diagnostics.
-  Cursor cursor(input);
-  // Points to the end of the previous positive match.
-  StringPiece previous_match_end = input.substr(0, 0);
-
-  // Returns a failure diagnostic without a message.;
-  auto fail = []() { return Diagnostic(Status::Fail); };
-  // Returns a string describing the filename, line, and column of a check rule,
-  // including the text of the check rule and a caret pointing to the parameter
-  // string.
-  auto check_msg = [&checks, &options](StringPiece where, StringPiece message) {
-    std::ostringstream out;
-    out << options.checks_name() << LineMessage(checks, where, message);
-    return out.str();
-  };
-  // Returns a string describing the filename, line, and column of an input
-  // string position, including the full line containing the position, and a
-  // caret pointing to the position.
-  auto input_msg = [&input, &options](StringPiece where, StringPiece message) {
-    std::ostringstream out;
-    out << options.input_name() << LineMessage(input, where, message);
-    return out.str();
-  };
-  // Returns a string describing the value of each variable use in the
-  // given check, in the context of the |where| portion of the input line.
-  auto var_notes = [&input_msg, &vars](StringPiece where, const Check& check) {
-    std::ostringstream out;
-    for (const auto& part : check.parts()) {
-      const auto var_use = part->VarUseName();
-      if (!var_use.empty()) {
-        std::ostringstream phrase;
-        std::string var_use_str(ToString(var_use));
-        if (vars.find(var_use_str) != vars.end()) {
-          phrase << "note: with variable \"" << var_use << "\" equal to \""
-                 << vars[var_use_str] << "\"";
-        } else {
-          phrase << "note: uses undefined variable \"" << var_use << "\"";
-        }
-        out << input_msg(where, phrase.str());
-      }
-    }
-    return out.str();
-  };
-
-  // For each line.
-  for (; !cursor.Exhausted(); cursor.AdvanceLine()) {
-    // Try to match the current line against the unresolved checks.
-
-    // The number of characters the cursor should advance to accommodate a
-    // recent DAG check match.
-    size_t deferred_advance = 0;
-
-    bool scan_this_line = true;
-    while (scan_this_line) {
-      // Skip the initial segment of resolved checks.  Slides the left end of
-      // the pattern window toward the right.
-      while (first_check < num_checks && resolved[first_check]) ++first_check;
-      // We've reached the end of the pattern.  Declare success.
-      if (first_check == num_checks) return Result(Result::Status::Ok);
+void CancellationToken::Cancel() {
+  impl_->cancelled.store(true, std::memory_order_relaxed);
+}
 
-      size_t first_unresolved_dag = num_checks;
-      size_t first_unresolved_negative = num_checks;
+bool CancellationToken::cancelled() const {
+  return impl_->cancelled.load(std::memory_order_relaxed);
+}
 
-      bool resolved_something = false;
+Result Match(StringPiece input, StringPiece checks, const Options& options) {
+  // The program is only used here, so it need not be shared or copy the
+  // check rules.
+  const Program::Impl program(checks, options, Program::Impl::Use::Once);
+  if (!program.parse_result()) return program.parse_result();
+  Matcher matcher(program, options.trace_matches());
+  matcher.Process(input);
+  return matcher.Finish();
+}
 
-      for (size_t i = first_check; i < num_checks; ++i) {
-        if (resolved[i]) continue;
+Result Program::Match(StringPiece input) const {
+  if (!impl_->parse_result()) return impl_->parse_result();
+  Matcher matcher(*impl_, impl_->options().trace_matches());
+  matcher.Process(input);
+  return matcher.Finish();
+}
 
-        const Check& check = pattern[i];
+namespace {
 
-        if (check.type() != Type::DAG) {
-          cursor.Advance(deferred_advance);
-          deferred_advance = 0;
-        }
-        const StringPiece rest_of_line = cursor.RestOfLine();
-        StringPiece unconsumed = rest_of_line;
-        StringPiece captured;
+// Returns true if the input name in |options| is the default one.
+bool HasDefaultInputName(const Options& options) {
+  return options.input_name() == Options().input_name();
+}
 
-        if (check.Matches(&unconsumed, &captured, &vars)) {
-          if (check.type() == Type::Not) {
-            return fail() << input_msg(captured,
-                                       "error: CHECK-NOT: string occurred!")
-                          << check_msg(
-                                 check.param(),
-                                 "note: CHECK-NOT: pattern specified here")
-                          << var_notes(captured, check);
-          }
+// Returns true if the check rules name in |options| is the default one.
+bool HasDefaultChecksName(const Options& options) {
+  return options.checks_name() == Options().checks_name();
+}
 
-          if (check.type() == Type::Same &&
-              cursor.line_num() != matched_line_num) {
-            return fail()
-                   << check_msg(check.param(),
-                                "error: CHECK-SAME: is not on the same line as "
-                                "previous match")
-                   << input_msg(captured, "note: 'next' match was here")
-                   << input_msg(previous_match_end,
-                                "note: previous match ended here");
-          }
+}  // namespace
+
+Result Program::MatchFile(StringPiece input_path) const {
+  if (!impl_->parse_result()) return impl_->parse_result();
+  const std::string path = ToString(input_path);
+  InputFile file;
+  Result result = file.Open(path);
+  if (!result) return result;
+
+  Matcher matcher(*impl_, false);
+  if (HasDefaultInputName(impl_->options())) matcher.SetInputName(path);
+  StringPiece contents;
+  if (file.Map(&contents)) {
+    matcher.Process(contents);
+    return matcher.Finish();
+  }
+  StringPiece chunk;
+  do {
+    result = file.Read(&chunk);
+    if (!result) return result;
+  } while (!chunk.empty() && matcher.Feed(chunk));
+  return matcher.Finish();
+}
 
-          if (check.type() == Type::Next) {
-            if (cursor.line_num() == matched_line_num) {
-              return fail()
-                     << check_msg(check.param(),
-                                  "error: CHECK-NEXT: is on the same line as "
-                                  "previous match")
-                     << input_msg(captured, "note: 'next' match was here")
-                     << input_msg(previous_match_end,
-                                  "note: previous match ended here")
-                     << var_notes(previous_match_end, check);
-            }
-            if (cursor.line_num() > 1 + matched_line_num) {
-              // This must be valid since there was an intervening line.
-              const auto non_match =
-                  Cursor(input)
-                      .Advance(previous_match_end.data() - input.data())
-                      .AdvanceLine()
-                      .RestOfLine();
+Result MatchFile(StringPiece input_path, StringPiece checks_path,
+                 const Options& options) {
+  Options file_options(options);
+  if (HasDefaultInputName(options)) file_options.SetInputName(input_path);
+  if (HasDefaultChecksName(options)) file_options.SetChecksName(checks_path);
+
+  InputFile checks_file;
+  Result result = checks_file.Open(ToString(checks_path));
+  if (!result) return result;
+  std::string storage;
+  StringPiece checks;
+  result = checks_file.ReadAll(&storage, &checks);
+  if (!result) return result;
+  return Program(checks, file_options).MatchFile(input_path);
+}
 
-              return fail()
-                     << check_msg(check.param(),
-                                  "error: CHECK-NEXT: is not on the line after "
-                                  "the previous match")
-                     << input_msg(captured, "note: 'next' match was here")
-                     << input_msg(previous_match_end,
-                                  "note: previous match ended here")
-                     << input_msg(non_match,
-                                  "note: non-matching line after previous "
-                                  "match is here")
-                     << var_notes(previous_match_end, check);
-            }
-          }
+std::vector<Result> MatchBatch(const Program& program,
+                               const std::vector<StringPiece>& inputs,
+                               unsigned num_threads) {
+  std::vector<Result> results(inputs.size(), Result(Result::Status::Ok));
+  if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+  num_threads = std::max(1u, std::min<unsigned>(num_threads,
+                                                unsigned(inputs.size())));
+
+  // Each worker repeatedly claims the next input.  Slow inputs don't hold
+  // up the others, as they would with a fixed partition.
+  std::atomic<size_t> next_input(0);
+  auto work = [&]() {
+    for (size_t i = next_input++; i < inputs.size(); i = next_input++) {
+      results[i] = program.Match(inputs[i]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < num_threads; ++t) workers.emplace_back(work);
+  work();
+  for (auto& worker : workers) worker.join();
+  return results;
+}
 
-          if (check.type() != Type::DAG && first_unresolved_dag < i) {
-            return fail()
-                   << check_msg(pattern[first_unresolved_dag].param(),
-                                "error: expected string not found in input")
-                   << input_msg(previous_match_end, "note: scanning from here")
-                   << input_msg(captured, "note: next check matches here")
-                   << var_notes(previous_match_end, check);
-          }
+class StreamingMatcher::Impl {
+ public:
+  explicit Impl(const Program& program) : program_(program) {
+    if (program_) {
+      matcher_ = effcee::make_unique<Matcher>(*program_.impl_, false);
+    }
+  }
 
-          resolved[i] = true;
-          matched_line_num = cursor.line_num();
-          previous_match_end = unconsumed;
-          resolved_something = true;
+  bool Feed(StringPiece chunk) { return matcher_ && matcher_->Feed(chunk); }
 
-          // Resolve any prior negative checks that precede an unresolved DAG.
-          for (auto j = first_unresolved_negative,
-                    limit = std::min(first_unresolved_dag, i);
-               j < limit; ++j) {
-            resolved[j] = true;
-          }
+  Result Finish() {
+    return matcher_ ? matcher_->Finish() : program_.compile_result();
+  }
 
-          // Normally advance past the matched text.  But DAG checks might need
-          // to match out of order on the same line.  So only advance for
-          // non-DAG cases.
+ private:
+  const Program program_;
+  // The match state, or null if the program is invalid.
+  std::unique_ptr<Matcher> matcher_;
+};
 
-          const size_t advance_proposal =
-              rest_of_line.size() - unconsumed.size();
-          if (check.type() == Type::DAG) {
-            deferred_advance = std::max(deferred_advance, advance_proposal);
-          } else {
-            cursor.Advance(advance_proposal);
-          }
+StreamingMatcher::StreamingMatcher(const Program& program)
+    : impl_(effcee::make_unique<Impl>(program)) {}
 
-        } else {
-          // This line did not match the check.
-          if (check.type() == Type::Not) {
-            first_unresolved_negative = std::min(first_unresolved_negative, i);
-            // An unresolved Not check stops the search for more DAG checks.
-            if (first_unresolved_dag < num_checks) i = num_checks;
-          } else if (check.type() == Type::DAG) {
-            first_unresolved_dag = std::min(first_unresolved_dag, i);
-          } else {
-            // An unresolved non-DAG check check stops this pass over the
-            // checks.
-            i = num_checks;
-          }
-        }
-      }
-      scan_this_line = resolved_something;
-    }
-  }
+StreamingMatcher::~StreamingMatcher() = default;
+StreamingMatcher::StreamingMatcher(StreamingMatcher&&) = default;
+StreamingMatcher& StreamingMatcher::operator=(StreamingMatcher&&) = default;
 
-  // Fail if there are any unresolved positive checks.
-  for (auto i = first_check; i < num_checks; ++i) {
-    if (resolved[i]) continue;
-    const auto check = pattern[i];
-    if (check.type() == Type::Not) continue;
+bool StreamingMatcher::Feed(StringPiece chunk) { return impl_->Feed(chunk); }
 
-    return fail() << check_msg(check.param(),
-                               "error: expected string not found in input")
-                  << input_msg(previous_match_end, "note: scanning from here")
-                  << var_notes(previous_match_end, check);
-  }
+Result StreamingMatcher::Finish() { return impl_->Finish(); }
 
-  return Result(Result::Status::Ok);
-}
 }  // namespace effcee
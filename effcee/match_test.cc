@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 
 #include "effcee.h"
@@ -20,6 +26,8 @@ namespace {
 
 using effcee::Match;
 using effcee::Options;
+using effcee::Result;
+using effcee::StringPiece;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 
@@ -53,6 +61,15 @@ TEST(Match, OneSimpleCheckFail) {
   EXPECT_THAT(result.message(), HasSubstr("CHECK: Hello"));
 }
 
+TEST(Match, ChecksWithSeveralPrefixesFormOneSequence) {
+  const auto options = Options().SetPrefixes({"CHECK", "CHECK-O2"});
+  const char* checks = "CHECK: Hello\nCHECK-O2-NEXT: fast\nCHECK: world";
+  EXPECT_TRUE(Match("Hello\nfast\nworld", checks, options));
+  const auto result = Match("Hello\nslow\nworld", checks, options);
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(), HasSubstr("CHECK-O2-NEXT: fast"));
+}
+
 TEST(Match, TwoSimpleChecksPass) {
   const auto result = Match("Hello\nWorld", "CHECK: Hello\nCHECK: World");
   EXPECT_TRUE(result) << result.message();
@@ -269,6 +286,70 @@ TEST(Match, TrailingNotSeenFails) {
   EXPECT_THAT(result.message(), HasSubstr("CHECK-NOT: Borg"));
 }
 
+TEST(Match, NotSeenAfterNextMatchOnSameLineFails) {
+  // A CHECK-NOT is tried against the whole line where the next check
+  // matches.
+  const auto result = Match("a\nc b\n", "CHECK: a\nCHECK-NOT: b\nCHECK: c");
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:2:3: error: CHECK-NOT: string occurred!"));
+}
+
+TEST(Match, NotSeenOnEarliestLineIsReported) {
+  const auto result =
+      Match("a\nb x\ny\nz\n",
+            "CHECK: a\nCHECK-NOT: y\nCHECK-NOT: x\nCHECK: z");
+  EXPECT_FALSE(result);
+  ASSERT_THAT(result.failure(), testing::NotNull());
+  EXPECT_THAT(result.failure()->check_index, Eq(2u));
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:2:3: error: CHECK-NOT: string occurred!"));
+}
+
+TEST(Match, FirstNotSeenOnALineIsReported) {
+  const auto result =
+      Match("a\ny x\nz\n", "CHECK: a\nCHECK-NOT: x\nCHECK-NOT: y\nCHECK: z");
+  EXPECT_FALSE(result);
+  ASSERT_THAT(result.failure(), testing::NotNull());
+  EXPECT_THAT(result.failure()->check_index, Eq(1u));
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:2:3: error: CHECK-NOT: string occurred!"));
+}
+
+TEST(Match, AnchoredNotSeenAtStartOfLaterLineFails) {
+  const auto result =
+      Match("a\nxb\nb\nc\n", "CHECK: a\nCHECK-NOT: {{^b}}\nCHECK: c");
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:3:1: error: CHECK-NOT: string occurred!"));
+}
+
+TEST(Match, NotRegexDoesNotMatchAcrossLines) {
+  EXPECT_TRUE(
+      Match("a\nx\nz\nc\n", "CHECK: a\nCHECK-NOT: {{x[^y]z}}\nCHECK: c"));
+  EXPECT_FALSE(
+      Match("a\nx\nxaz\nc\n", "CHECK: a\nCHECK-NOT: {{x[^y]z}}\nCHECK: c"));
+}
+
+TEST(Match, NotUsesVariableValueBeforeEarlierNotDefinesIt) {
+  const auto result = Match("q\nab\nb x1\nEND\n",
+                            "CHECK-NOT: [[W:a?]] x1\nCHECK-NOT: [[W]]\n"
+                            "CHECK: END");
+  EXPECT_FALSE(result);
+  ASSERT_THAT(result.failure(), testing::NotNull());
+  EXPECT_THAT(result.failure()->check_index, Eq(0u));
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:3:2: error: CHECK-NOT: string occurred!"));
+}
+
+TEST(Match, NotUsesVariableValueBeforeNextCheckRedefinesIt) {
+  const auto result = Match(
+      "a\nya\nb\n", "CHECK: [[X:\\w+]]\nCHECK-NOT: y[[X]]\nCHECK: [[X:\\w+]]");
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:2:1: error: CHECK-NOT: string occurred!"));
+}
+
 // WIP: CHECK-LABEL
 
 TEST(Match, OneLabelCheckPass) {
@@ -513,6 +594,38 @@ TEST(Match, TwoDAGsAreTerminatedBySimple) {
   EXPECT_THAT(result.message(), HasSubstr("CHECK-DAG: Ante"));
 }
 
+TEST(Match, RegexDAGsMatchOutOfOrder) {
+  const auto result =
+      Match("b2\na1\nc3",
+            "CHECK-DAG: a{{[0-9]}}\nCHECK-DAG: b{{[0-9]}}\n"
+            "CHECK-DAG: c{{[0-9]}}");
+  EXPECT_TRUE(result) << result.message();
+}
+
+TEST(Match, RegexDAGsOnSameLine) {
+  const auto result =
+      Match("b2 a1", "CHECK-DAG: a{{[0-9]}}\nCHECK-DAG: b{{[0-9]}}");
+  EXPECT_TRUE(result) << result.message();
+}
+
+TEST(Match, RegexDAGMissingFails) {
+  const auto result =
+      Match("b2\na1", "CHECK-DAG: a{{[0-9]}}\nCHECK-DAG: c{{[0-9]}}\n"
+                      "CHECK-DAG: b{{[0-9]}}");
+  EXPECT_FALSE(result) << result.message();
+  EXPECT_THAT(result.message(), HasSubstr(kNotFound));
+  EXPECT_THAT(result.message(), HasSubstr("CHECK-DAG: c{{[0-9]}}"));
+}
+
+TEST(Match, RegexNotAmongRegexDAGsFails) {
+  const auto result =
+      Match("a1\nz9\nb2", "CHECK-DAG: a{{[0-9]}}\nCHECK-NOT: z{{[0-9]}}\n"
+                           "CHECK-NOT: y{{[0-9]}}\nCHECK: b{{[0-9]}}");
+  EXPECT_FALSE(result) << result.message();
+  EXPECT_THAT(result.message(), HasSubstr(kNotStrFound));
+  EXPECT_THAT(result.message(), HasSubstr("CHECK-NOT: z{{[0-9]}}"));
+}
+
 // Test detailed message text
 
 TEST(Match, MessageStringNotFoundWhenNeverMatchedAnything) {
@@ -590,6 +703,38 @@ CHECK-NOT: Cheese
   EXPECT_THAT(result.message(), Eq(expected)) << result.message();
 }
 
+TEST(Match, FailureDescribesCheckNot) {
+  const auto result =
+      Match("Cream    Cheese", "CHECK: Cream\nCHECK-NOT: Cheese",
+            Options().SetInputName("in").SetChecksName("checks"));
+  EXPECT_FALSE(result);
+  const auto* failure = result.failure();
+  ASSERT_NE(failure, nullptr);
+  EXPECT_THAT(failure->check_index, Eq(1u));
+  EXPECT_THAT(failure->input_name, Eq("in"));
+  EXPECT_THAT(failure->checks_name, Eq("checks"));
+  ASSERT_THAT(failure->notes.size(), Eq(2u));
+  const auto& input_note = failure->notes[0];
+  EXPECT_THAT(input_note.source, Eq(Result::Note::Source::Input));
+  EXPECT_THAT(input_note.offset, Eq(9u));
+  EXPECT_THAT(input_note.line_num, Eq(1));
+  EXPECT_THAT(input_note.column, Eq(10));
+  EXPECT_THAT(input_note.line, Eq("Cream    Cheese"));
+  const auto& checks_note = failure->notes[1];
+  EXPECT_THAT(checks_note.source, Eq(Result::Note::Source::Checks));
+  EXPECT_THAT(checks_note.offset, Eq(24u));
+  EXPECT_THAT(checks_note.line_num, Eq(2));
+  EXPECT_THAT(checks_note.column, Eq(12));
+  EXPECT_THAT(checks_note.message,
+              Eq("note: CHECK-NOT: pattern specified here"));
+}
+
+TEST(Match, NoFailureDescriptionOnSuccess) {
+  const auto result = Match("Cheese", "CHECK: Cheese");
+  EXPECT_TRUE(result);
+  EXPECT_THAT(result.failure(), Eq(nullptr));
+}
+
 TEST(Match, MessageCheckSameFails) {
   const char* input = R"(
 Bees
@@ -672,6 +817,62 @@ Bees Make Delicious Honey
   EXPECT_THAT(result.message(), Eq(expected)) << result.message();
 }
 
+TEST(Match, MessageCheckNextFailsAfterSkippedLines) {
+  const char* input = R"(one
+two
+Bees Make
+Delicious
+Honey
+three
+)";
+  const char* checks = R"(
+CHECK: Make
+CHECK-NEXT: Honey
+)";
+
+  const auto result = Match(
+      input, checks, Options().SetInputName("in").SetChecksName("checks"));
+  EXPECT_FALSE(result);
+  const char* expected = R"(checks:3:13: error: CHECK-NEXT: is not on the line after the previous match
+CHECK-NEXT: Honey
+            ^
+in:5:1: note: 'next' match was here
+Honey
+^
+in:3:10: note: previous match ended here
+Bees Make
+         ^
+in:4:1: note: non-matching line after previous match is here
+Delicious
+^
+)";
+  EXPECT_THAT(result.message(), Eq(expected)) << result.message();
+}
+
+TEST(Match, MessageStringNotFoundAfterSkippedLines) {
+  const char* input = R"(one
+two
+Bees Make
+Delicious
+)";
+  const char* checks = R"(
+CHECK: Make
+CHECK: Honey
+)";
+
+  const auto result = Match(
+      input, checks, Options().SetInputName("in").SetChecksName("checks"));
+  EXPECT_FALSE(result);
+  const char* expected = R"(checks:3:8: error: expected string not found in input
+CHECK: Honey
+       ^
+in:3:10: note: scanning from here
+Bees Make
+         ^
+)";
+  EXPECT_THAT(result.message(), Eq(expected)) << result.message();
+}
+
 TEST(Match, MessageUnresolvedDAG) {
   const char* input = R"(
 Bees
@@ -795,6 +996,16 @@ TEST(Match, VarDefFollowedByUseFail) {
               HasSubstr("note: with variable \"X\" equal to \"ell\""));
 }
 
+TEST(Match, FailureRecordsVariableValues) {
+  const auto result =
+      Match("Hello\n\nWorld", "CHECK: H[[X:[a-z]+]]o\nCHECK: H[[X]]o");
+  EXPECT_FALSE(result);
+  ASSERT_NE(result.failure(), nullptr);
+  EXPECT_THAT(result.failure()->check_index, Eq(1u));
+  using Variables = std::vector<std::pair<std::string, std::string>>;
+  EXPECT_THAT(result.failure()->variables, Eq(Variables{{"X", "ell"}}));
+}
+
 TEST(Match, VarDefFollowedByUseFailAfterDAG) {
   const auto result =
       Match("Hello\nWorld",
@@ -891,4 +1102,286 @@ Firstababab1abab
   EXPECT_THAT(result.message(), HasSubstr(substr));
 }
 
+// Match trace
+
+TEST(Match, NoTraceByDefault) {
+  const auto result = Match("abc", "CHECK: b");
+  EXPECT_TRUE(result);
+  EXPECT_TRUE(result.trace().empty());
+}
+
+TEST(Match, TraceRecordsEachCheck) {
+  const std::string input = "one\ntwo x=12\nthree\n";
+  const auto result =
+      Match(input,
+            "CHECK: one\nCHECK-NOT: four\nCHECK: x=[[X:[0-9]+]]\n"
+            "CHECK-NEXT: th{{r+}}ee",
+            Options().SetTraceMatches(true));
+  EXPECT_TRUE(result) << result.message();
+  const auto& trace = result.trace();
+  ASSERT_THAT(trace.size(), Eq(4u));
+
+  EXPECT_TRUE(trace[0].matched);
+  EXPECT_THAT(trace[0].text, Eq("one"));
+  EXPECT_THAT(trace[0].text.data(), Eq(input.data()));
+  EXPECT_THAT(trace[0].offset, Eq(0u));
+  EXPECT_THAT(trace[0].line_num, Eq(1));
+  EXPECT_TRUE(trace[0].captures.empty());
+
+  EXPECT_FALSE(trace[1].matched);
+
+  EXPECT_TRUE(trace[2].matched);
+  EXPECT_THAT(trace[2].text, Eq("x=12"));
+  EXPECT_THAT(trace[2].offset, Eq(8u));
+  EXPECT_THAT(trace[2].line_num, Eq(2));
+  ASSERT_THAT(trace[2].captures.size(), Eq(1u));
+  EXPECT_THAT(trace[2].captures[0].name, Eq("X"));
+  EXPECT_THAT(trace[2].captures[0].value, Eq("12"));
+  EXPECT_THAT(trace[2].captures[0].value.data(), Eq(input.data() + 10));
+  EXPECT_THAT(trace[2].captures[0].offset, Eq(10u));
+
+  EXPECT_TRUE(trace[3].matched);
+  EXPECT_THAT(trace[3].text, Eq("three"));
+  EXPECT_THAT(trace[3].offset, Eq(13u));
+  EXPECT_THAT(trace[3].line_num, Eq(3));
+}
+
+TEST(Match, TraceRecordsDAGChecksOnOneLine) {
+  const auto result = Match("b a", "CHECK-DAG: a\nCHECK-DAG: b",
+                            Options().SetTraceMatches(true));
+  EXPECT_TRUE(result) << result.message();
+  ASSERT_THAT(result.trace().size(), Eq(2u));
+  EXPECT_THAT(result.trace()[0].offset, Eq(2u));
+  EXPECT_THAT(result.trace()[1].offset, Eq(0u));
+}
+
+TEST(Match, TraceKeepsCapturesOfCheckAfterDeferredNot) {
+  // The CHECK-NOT is tried against line 2 once the last check matches.
+  const auto result =
+      Match("a\nx z\nbb\n", "CHECK: a\nCHECK-NOT: x{{ y}}\nCHECK: [[V:b+]]",
+            Options().SetTraceMatches(true));
+  EXPECT_TRUE(result) << result.message();
+  ASSERT_THAT(result.trace().size(), Eq(3u));
+  ASSERT_THAT(result.trace()[2].captures.size(), Eq(1u));
+  EXPECT_THAT(result.trace()[2].captures[0].name, Eq("V"));
+  EXPECT_THAT(result.trace()[2].captures[0].value, Eq("bb"));
+}
+
+TEST(Match, NoTraceOnFailure) {
+  const auto result =
+      Match("abc", "CHECK: x", Options().SetTraceMatches(true));
+  EXPECT_FALSE(result);
+  EXPECT_TRUE(result.trace().empty());
+}
+
+// Resource limits
+
+// A regex of about a thousand instructions, which needs more than 10000
+// bytes of regex memory.
+const char kLargeRegexChecks[] = "CHECK: {{([a-z]{1000})+}}";
+
+TEST(Match, RegexWithinMemoryLimitMatches) {
+  EXPECT_TRUE(Match(std::string(1000, 'a'), kLargeRegexChecks,
+                    Options().SetRegexMaxMem(1 << 22)));
+}
+
+TEST(Match, RegexOverMemoryLimitIsResourceExhausted) {
+  const auto result = Match(std::string(1000, 'a'), kLargeRegexChecks,
+                            Options().SetRegexMaxMem(10000));
+  EXPECT_THAT(result.status(), Eq(Result::Status::ResourceExhausted));
+  EXPECT_THAT(result.message(),
+              Eq("<stdin>:1:8: regex needs more than the memory limit of "
+                 "10000 bytes: {{([a-z]{1000})+}}"));
+}
+
+TEST(Match, RegexUsingVariablesOverMemoryLimitIsResourceExhausted) {
+  const auto result =
+      Match("x\n", "CHECK: [[X:x]]\nCHECK: [[X]]{{([a-z]{1000})+}}",
+            Options().SetRegexMaxMem(10000));
+  EXPECT_THAT(result.status(), Eq(Result::Status::ResourceExhausted));
+  EXPECT_THAT(result.message(), HasSubstr("<stdin>:2:8: regex needs more"));
+}
+
+TEST(Match, MatchWithinScanBudgetPasses) {
+  EXPECT_TRUE(Match("aaa\nbbb\nccc\n", "CHECK-NOT: x\nCHECK: ccc",
+                    Options().SetScanBudget(100)));
+}
+
+TEST(Match, MatchOverScanBudgetIsResourceExhausted) {
+  // The second check is tried against line 3 only, costing 4 bytes.  Then
+  // the first check is searched for over all 12 bytes before it.
+  const auto result = Match("aaa\nbbb\nccc\n", "CHECK-NOT: x\nCHECK: ccc",
+                            Options().SetScanBudget(12));
+  EXPECT_THAT(result.status(), Eq(Result::Status::ResourceExhausted));
+  ASSERT_THAT(result.failure(), testing::NotNull());
+  EXPECT_THAT(result.failure()->check_index, Eq(0u));
+  EXPECT_THAT(result.message(),
+              Eq("<stdin>:1:12: error: scan budget of 12 bytes exhausted by "
+                 "this check\n"
+                 "CHECK-NOT: x\n"
+                 "           ^\n"
+                 "<stdin>:1:1: note: scanning from here\n"
+                 "aaa\n"
+                 "^\n"));
+}
+
+// Deadlines and cancellation
+
+TEST(Match, CancelledTokenStopsMatch) {
+  auto token = std::make_shared<effcee::CancellationToken>();
+  token->Cancel();
+  const auto result = Match("abc\n", "CHECK: c",
+                            Options().SetCancellationToken(token));
+  EXPECT_THAT(result.status(), Eq(Result::Status::Cancelled));
+  EXPECT_THAT(result.message(),
+              Eq("<stdin>:1:1: error: match cancelled here\n"
+                 "abc\n"
+                 "^\n"
+                 "<stdin>:1:8: note: while trying this check\n"
+                 "CHECK: c\n"
+                 "       ^\n"));
+}
+
+TEST(Match, UncancelledTokenLetsMatchFinish) {
+  auto token = std::make_shared<effcee::CancellationToken>();
+  EXPECT_TRUE(
+      Match("abc\n", "CHECK: c", Options().SetCancellationToken(token)));
+}
+
+TEST(Match, PassedDeadlineStopsMatch) {
+  const auto result =
+      Match("abc\n", "CHECK: c",
+            Options().SetDeadline(std::chrono::steady_clock::now()));
+  EXPECT_THAT(result.status(), Eq(Result::Status::Cancelled));
+  EXPECT_THAT(result.message(),
+              HasSubstr("<stdin>:1:1: error: match deadline passed here"));
+}
+
+TEST(Match, FutureDeadlineLetsMatchFinish) {
+  EXPECT_TRUE(Match("abc\n", "CHECK: c",
+                    Options().SetDeadline(std::chrono::steady_clock::now() +
+                                          std::chrono::hours(1))));
+}
+
+TEST(Match, CancellationStopsStreamingMatch) {
+  // The token is cancelled between two chunks of a long input.
+  auto token = std::make_shared<effcee::CancellationToken>();
+  std::string input;
+  for (int i = 0; i < 100000; ++i) input += "OpNop\n";
+  const effcee::Program program(
+      "CHECK-NOT: {{Op[A-Z]+x}}\nCHECK: never",
+      Options().SetCancellationToken(token));
+  effcee::StreamingMatcher matcher(program);
+  EXPECT_TRUE(matcher.Feed(input));
+  token->Cancel();
+  EXPECT_FALSE(matcher.Feed(input));
+  const auto result = matcher.Finish();
+  EXPECT_THAT(result.status(), Eq(Result::Status::Cancelled));
+  // The match stopped at the start of the second chunk.
+  EXPECT_THAT(result.message(), HasSubstr("<stdin>:100001:1: error: match "
+                                          "cancelled here"));
+}
+
+// Matching files
+
+// Writes |contents| to a new temporary file, and returns its path.
+std::string WriteTempFile(const std::string& name,
+                          const std::string& contents) {
+  const std::string path = ::testing::TempDir() + name;
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  std::fwrite(contents.data(), 1, contents.size(), file);
+  std::fclose(file);
+  return path;
+}
+
+TEST(MatchFile, Pass) {
+  const std::string input = WriteTempFile("pass.in", "Hello\nWorld\n");
+  const std::string checks =
+      WriteTempFile("pass.checks", "CHECK: Hello\nCHECK-NEXT: World\n");
+  const auto result = effcee::MatchFile(input, checks);
+  EXPECT_TRUE(result) << result.message();
+  std::remove(input.c_str());
+  std::remove(checks.c_str());
+}
+
+TEST(MatchFile, MessageNamesFilesByPath) {
+  const std::string input = WriteTempFile("fail.in", "Hello\n");
+  const std::string checks = WriteTempFile("fail.checks", "CHECK: World\n");
+  const auto result = effcee::MatchFile(input, checks);
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(),
+              HasSubstr(checks + ":1:8: error: expected string not found"));
+  EXPECT_THAT(result.message(),
+              HasSubstr(input + ":1:1: note: scanning from here"));
+  std::remove(input.c_str());
+  std::remove(checks.c_str());
+}
+
+TEST(MatchFile, MessageUsesNamesFromOptions) {
+  const std::string input = WriteTempFile("named.in", "Hello\n");
+  const std::string checks = WriteTempFile("named.checks", "CHECK: World\n");
+  const auto result = effcee::MatchFile(
+      input, checks, Options().SetInputName("in").SetChecksName("checks"));
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(), HasSubstr("checks:1:8: error"));
+  EXPECT_THAT(result.message(), HasSubstr("in:1:1: note"));
+  std::remove(input.c_str());
+  std::remove(checks.c_str());
+}
+
+TEST(MatchFile, MissingFilesFail) {
+  const std::string missing = ::testing::TempDir() + "missing";
+  const std::string checks = WriteTempFile("missing.checks", "CHECK: a\n");
+  EXPECT_THAT(effcee::MatchFile(missing, checks).status(),
+              Eq(Result::Status::BadFile));
+  EXPECT_THAT(effcee::MatchFile(checks, missing).status(),
+              Eq(Result::Status::BadFile));
+  std::remove(checks.c_str());
+}
+
+TEST(MatchFile, ProgramMatchesSeveralFiles) {
+  const effcee::Program program("CHECK: Hello");
+  const std::string pass = WriteTempFile("several.pass", "Hello\n");
+  const std::string fail = WriteTempFile("several.fail", "Bye\n");
+  EXPECT_TRUE(program.MatchFile(pass));
+  const auto result = program.MatchFile(fail);
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(), HasSubstr(fail + ":1:1: note"));
+  std::remove(pass.c_str());
+  std::remove(fail.c_str());
+}
+
+// Matching a batch of inputs
+
+TEST(MatchBatch, EmptyBatch) {
+  const effcee::Program program("CHECK: a");
+  EXPECT_TRUE(effcee::MatchBatch(program, {}).empty());
+}
+
+TEST(MatchBatch, ResultsAreInInputOrder) {
+  const effcee::Program program("CHECK: a\nCHECK-NEXT: b");
+  std::vector<std::string> texts;
+  for (int i = 0; i < 100; ++i) {
+    texts.push_back(i % 3 ? "a\nb\n" : "a\nc\nb\n");
+  }
+  const std::vector<StringPiece> inputs(texts.begin(), texts.end());
+  for (unsigned num_threads : {0u, 1u, 4u, 200u}) {
+    const auto results = effcee::MatchBatch(program, inputs, num_threads);
+    ASSERT_THAT(results.size(), Eq(inputs.size()));
+    for (size_t i = 0; i < results.size(); ++i) {
+      EXPECT_THAT(bool(results[i]), Eq(i % 3 != 0)) << i;
+      EXPECT_THAT(results[i].message(),
+                  Eq(program.Match(inputs[i]).message()));
+    }
+  }
+}
+
+TEST(MatchBatch, InvalidProgramGivesCompileResultForEachInput) {
+  const effcee::Program program("no rules");
+  const auto results = effcee::MatchBatch(program, {"a", "b"}, 2);
+  ASSERT_THAT(results.size(), Eq(2u));
+  EXPECT_THAT(results[0].status(), Eq(Result::Status::NoRules));
+  EXPECT_THAT(results[1].status(), Eq(Result::Status::NoRules));
+}
+
 }  // namespace
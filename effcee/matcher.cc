@@ -0,0 +1,846 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "matcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "cursor.h"
+#include "diagnostic.h"
+#include "effcee.h"
+#include "make_unique.h"
+#include "program.h"
+#include "search.h"
+#include "to_string.h"
+
+using Status = effcee::Result::Status;
+using Type = effcee::Check::Type;
+
+namespace {
+// The number of input bytes tried between polls of the cancellation token
+// and the deadline.  Each try counts at least one byte.
+const size_t kPollBytes = 1 << 16;
+}  // namespace
+
+namespace effcee {
+
+Matcher::Matcher(const Program::Impl& program, bool trace)
+    : program_(program),
+      pattern_(program.check_list()),
+      num_checks_(pattern_.size()),
+      input_name_(program.options().input_name()),
+      stats_(program.options().collect_stats() ||
+                     program.options().profile_checks()
+                 ? effcee::make_unique<MatchStats>(program.parse_stats())
+                 : nullptr),
+      sink_(program.options().trace_event_sink()),
+      match_start_(sink_ ? StatsClock::now() : StatsClock::time_point()),
+      search_start_(match_start_),
+      search_start_line_(1),
+      window_check_(num_checks_),
+      window_start_line_(1),
+      line_num_(1),
+      scan_budget_(program.options().scan_budget()),
+      bytes_tried_(0),
+      cancellation_token_(program.options().cancellation_token()),
+      has_deadline_(program.options().has_deadline()),
+      deadline_(program.options().deadline()),
+      bytes_since_poll_(0),
+      resolved_(num_checks_, false),
+      first_check_(0),
+      defer_until_(num_checks_),
+      deferred_from_(nullptr),
+      matched_line_num_(0),
+      group_scanner_(program.group_filter(), stats_.get()),
+      trace_matches_(trace),
+      trace_(trace ? num_checks_ : 0),
+      started_(false),
+      base_offset_(0),
+      base_line_num_(1),
+      text_lines_(effcee::make_unique<LineIndex>(text_)),
+      next_offset_(0),
+      next_line_num_(1),
+      base_cursor_line_num_(1),
+      next_cursor_line_num_(1),
+      suspended_(false),
+      previous_in_retained_(false),
+      retained_offset_(0),
+      retained_line_num_(0),
+      retained_lines_needed_(0),
+      decided_(false),
+      result_(Status::Ok) {
+  assert(num_checks_ > 0);
+  // Returns true if check |def| defines a variable that check |use| uses.
+  auto defines_used = [](const Check& def, const Check& use) {
+    for (const auto& def_part : def.parts()) {
+      if (def_part.VarDefName().empty()) continue;
+      for (const auto& use_part : use.parts()) {
+        if (!use_part.VarUseName().empty() &&
+            use_part.VarSlot() == def_part.VarSlot()) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+  for (size_t i = 0; i < num_checks_; ++i) defer_until_[i] = i;
+  for (size_t start = 0; start < num_checks_; ++start) {
+    if (pattern_[start].type() != Type::Not) continue;
+    size_t end = start;
+    while (end < num_checks_ && pattern_[end].type() == Type::Not) ++end;
+    // A DAG check after the run might match before the end of its range.
+    bool deferred = end == num_checks_ || pattern_[end].type() != Type::DAG;
+    // The run is tried after the check following it matches, so that check
+    // must not change the variables the run uses.
+    for (size_t i = start; end < num_checks_ && i < end; ++i) {
+      if (defines_used(pattern_[end], pattern_[i])) deferred = false;
+    }
+    // Each check of the run is tried over the whole range before the next
+    // one is, so a match of one must not change the variables a later one
+    // uses.
+    for (size_t i = start; i < end; ++i) {
+      for (size_t j = i + 1; j < end; ++j) {
+        if (defines_used(pattern_[i], pattern_[j])) deferred = false;
+      }
+    }
+    if (deferred) {
+      for (size_t i = start; i < end; ++i) defer_until_[i] = end;
+    }
+    start = end;
+  }
+  if (program.options().profile_checks()) {
+    for (size_t i = 0; i < num_checks_; ++i) {
+      const Check& check = pattern_[i];
+      profile_.push_back({i, check.line_num(), check.column(),
+                          ToString(RuleLine(check)), 0, 0, 0, 0});
+    }
+  }
+}
+
+bool Matcher::Decide(Result result) {
+  if (stats_ && !result) {
+    stats_->diagnostic_seconds += SecondsSince(diagnostic_start_);
+  }
+  if (sink_) {
+    if (!result) {
+      const size_t i = result.failure()->check_index;
+      RecordSpan(sink_, "Diagnostic", "match", diagnostic_start_,
+                 {{"check_line", std::to_string(pattern_[i].line_num())},
+                  {"rule", ToString(RuleLine(pattern_[i]))}});
+    }
+    // Close the window of DAG and NOT checks, if one is open.
+    TraceWindow(num_checks_, line_num_);
+    RecordSpan(sink_, "Match", "match", match_start_,
+               {{"input", input_name_},
+                {"result", result ? "pass" : "fail"}});
+  }
+  decided_ = true;
+  result_ = std::move(result);
+  return false;
+}
+
+Diagnostic Matcher::Fail(size_t check_index, Status status) const {
+  if (stats_ || sink_) diagnostic_start_ = StatsClock::now();
+  return Diagnostic(status, check_index, input_name_,
+                    program_.options().checks_name());
+}
+
+Result::Note Matcher::CheckNote(const Check& check,
+                                const char* message) const {
+  const LineIndex& checks_lines = program_.checks_lines();
+  const StringPiece where = check.param();
+  Result::Note note;
+  note.source = Result::Note::Source::Checks;
+  note.offset = size_t(where.data() - checks_lines.text().data());
+  note.line_num = check.line_num();
+  const StringPiece line = checks_lines.Line(note.line_num);
+  note.column = int(1 + where.data() - line.data());
+  note.line = ToString(line);
+  note.message = message;
+  return note;
+}
+
+Result::Note Matcher::InputNote(StringPiece where, bool retained,
+                                std::string message) const {
+  const LineIndex retained_lines(retained_);
+  const LineIndex& lines = retained ? retained_lines : *text_lines_;
+  Result::Note note;
+  note.source = Result::Note::Source::Input;
+  if (!retained && where.empty() && where.data() == text_.data() &&
+      base_offset_ > 0) {
+    // A position at the start of a line is described at the end of the
+    // line before, which ended the previous text.
+    note.offset = base_offset_;
+    note.line_num = base_line_num_ - 1;
+    note.column = int(1 + previous_text_last_line_.size());
+    note.line = previous_text_last_line_;
+    note.message = std::move(message);
+    return note;
+  }
+  const int line_num = lines.LineNumOfEnd(where);
+  const StringPiece line = lines.Line(line_num);
+  note.offset = (retained ? retained_offset_ : base_offset_) +
+                size_t(where.data() - lines.text().data());
+  note.line_num =
+      (retained ? retained_line_num_ : base_line_num_) + line_num - 1;
+  note.column = int(1 + where.data() - line.data());
+  note.line = ToString(line);
+  note.message = std::move(message);
+  return note;
+}
+
+VariableNotes Matcher::VarNotes(StringPiece where, bool retained,
+                                const Check& check) const {
+  VariableNotes result;
+  for (const auto& part : check.parts()) {
+    const auto var_use = part.VarUseName();
+    if (!var_use.empty()) {
+      std::string phrase;
+      if (vars_.IsSet(part.VarSlot())) {
+        const StringPiece value = vars_.Get(part.VarSlot());
+        result.variables.emplace_back(ToString(var_use), ToString(value));
+        phrase = "note: with variable \"" + result.variables.back().first +
+                 "\" equal to \"" + result.variables.back().second + "\"";
+      } else {
+        phrase = "note: uses undefined variable \"" + ToString(var_use) + "\"";
+      }
+      result.notes.push_back(InputNote(where, retained, std::move(phrase)));
+    }
+  }
+  return result;
+}
+
+void Matcher::Retain() {
+  vars_.Own();
+  if (!started_ || text_.data() == nullptr) return;
+  // The text is about to go away.
+  const StringPiece text = text_;
+  text_ = StringPiece();
+  if (!text.empty()) {
+    const size_t last_newline =
+        FindLastChar(text.substr(0, text.size() - 1), '\n');
+    previous_text_last_line_ = ToString(text.substr(
+        last_newline == StringPiece::npos ? 0 : last_newline + 1));
+  }
+  if (previous_in_retained_) return;
+  // Keep the line holding the previous match, through the line after the
+  // one a cursor at the end of the match is on.  The lines not in this text
+  // are taken from the next texts.
+  const size_t line_start =
+      size_t(previous_match_line_.data() - text.data());
+  const size_t pos = size_t(previous_match_end_.data() - text.data());
+  Cursor cursor(text.substr(pos));
+  const bool at_end = cursor.Exhausted();
+  const StringPiece next_line = cursor.AdvanceLine().RestOfLine();
+  const size_t end = size_t(next_line.data() + next_line.size() - text.data());
+  retained_.assign(text.data() + line_start, end - line_start);
+  retained_offset_ = base_offset_ + line_start;
+  retained_line_num_ = base_line_num_ + text_lines_->LineNum(line_start) - 1;
+  retained_lines_needed_ = at_end ? 2 : next_line.empty() ? 1 : 0;
+  previous_match_end_ = StringPiece(retained_.data() + (pos - line_start),
+                                    previous_match_end_.size());
+  previous_in_retained_ = true;
+  previous_match_line_ = StringPiece();
+}
+
+const char* Matcher::StopReason() const {
+  if (cancellation_token_ && cancellation_token_->cancelled()) {
+    return "error: match cancelled here";
+  }
+  if (has_deadline_ && StatsClock::now() >= deadline_) {
+    return "error: match deadline passed here";
+  }
+  return nullptr;
+}
+
+StringPiece Matcher::RuleLine(const Check& check) const {
+  StringPiece rule = program_.checks_lines().Line(check.line_num());
+  while (!rule.empty() && (rule[rule.size() - 1] == '\n' ||
+                           rule[rule.size() - 1] == '\r')) {
+    rule.remove_suffix(1);
+  }
+  return rule;
+}
+
+void Matcher::TraceCheck(size_t i, int line_num) {
+  const Check& check = pattern_[i];
+  RecordSpan(sink_, "Check", "match", search_start_,
+             {{"check_line", std::to_string(check.line_num())},
+              {"rule", ToString(RuleLine(check))},
+              {"input_lines", std::to_string(search_start_line_) + "-" +
+                                  std::to_string(line_num)}});
+  search_start_ = StatsClock::now();
+  search_start_line_ = line_num;
+}
+
+void Matcher::TraceWindow(size_t first_check, int line_num) {
+  if (window_check_ == first_check) return;
+  auto is_window_check = [this](size_t i) {
+    return i < num_checks_ && (pattern_[i].type() == Type::DAG ||
+                               pattern_[i].type() == Type::Not);
+  };
+  size_t end = window_check_;
+  while (is_window_check(end)) ++end;
+  // Resolving a check in the window does not leave it.
+  if (window_check_ < first_check && first_check < end) return;
+  if (window_check_ < end) {
+    RecordSpan(sink_, "Window", "match", window_start_,
+               {{"check_lines",
+                 std::to_string(pattern_[window_check_].line_num()) + "-" +
+                     std::to_string(pattern_[end - 1].line_num())},
+                {"input_lines", std::to_string(window_start_line_) + "-" +
+                                    std::to_string(line_num)}});
+  }
+  window_check_ = first_check;
+  window_start_ = StatsClock::now();
+  window_start_line_ = line_num;
+}
+
+bool Matcher::TryCheck(size_t i, StringPiece* text, StringPiece* captured) {
+  return group_scanner_.MightMatch(i, *text) &&
+         pattern_[i].Matches(text, captured, &vars_,
+                             trace_matches_ ? &var_captures_ : nullptr,
+                             stats_.get());
+}
+
+bool Matcher::ProfileCheck(size_t i, StringPiece* text,
+                           StringPiece* captured) {
+  Result::CheckProfile& entry = profile_[i];
+  const size_t regex_matches = stats_->regex_matches;
+  const auto start = StatsClock::now();
+  ++entry.lines_probed;
+  bool matched = false;
+  if (group_scanner_.MightMatch(i, *text)) {
+    ++entry.match_attempts;
+    matched = pattern_[i].Matches(text, captured, &vars_,
+                                  trace_matches_ ? &var_captures_ : nullptr,
+                                  stats_.get());
+  }
+  entry.seconds += SecondsSince(start);
+  entry.regex_matches += stats_->regex_matches - regex_matches;
+  return matched;
+}
+
+size_t Matcher::SearchCheck(size_t i, StringPiece text) {
+  if (profile_.empty()) return pattern_[i].Search(text, vars_, stats_.get());
+  Result::CheckProfile& entry = profile_[i];
+  const size_t regex_matches = stats_->regex_matches;
+  const auto start = StatsClock::now();
+  const size_t pos = pattern_[i].Search(text, vars_, stats_.get());
+  entry.seconds += SecondsSince(start);
+  entry.regex_matches += stats_->regex_matches - regex_matches;
+  return pos;
+}
+
+bool Matcher::Charge(size_t i, StringPiece text) {
+  const Check& check = pattern_[i];
+  // The text may span lines.  Point at its start.
+  const StringPiece where = Cursor(text).RestOfLine();
+  if (scan_budget_ > 0) {
+    bytes_tried_ += text.size();
+    if (bytes_tried_ > scan_budget_) {
+      const std::string message = "error: scan budget of " +
+                                  std::to_string(scan_budget_) +
+                                  " bytes exhausted by this check";
+      return Decide(Fail(i, Status::ResourceExhausted)
+                    << CheckNote(check, message.c_str())
+                    << InputNote(where, false, "note: scanning from here"));
+    }
+  }
+  if (cancellation_token_ || has_deadline_) {
+    bytes_since_poll_ += text.size() + 1;
+    if (bytes_since_poll_ >= kPollBytes) {
+      bytes_since_poll_ = 0;
+      if (const char* reason = StopReason()) {
+        return Decide(Fail(i, Status::Cancelled)
+                      << InputNote(where, false, reason)
+                      << CheckNote(check, "note: while trying this check"));
+      }
+    }
+  }
+  return true;
+}
+
+bool Matcher::TryDeferredNots(size_t first, StringPiece range) {
+  size_t found = num_checks_;
+  StringPiece found_captured;
+  // Only a match on a line before the one found so far matters.
+  size_t limit = range.size();
+  for (size_t i = first; i < num_checks_ && pattern_[i].type() == Type::Not;
+       ++i) {
+    // The offset of the line to search from.
+    size_t from = 0;
+    while (from < limit) {
+      const StringPiece rest = range.substr(from, limit - from);
+      size_t pos = SearchCheck(i, rest);
+      if (pos == StringPiece::npos) {
+        if (!Charge(i, rest)) return false;
+        break;
+      }
+      // Try the line holding the candidate match.
+      pos = std::min(pos, rest.size() - 1);
+      const size_t newline_before = FindLastChar(rest.substr(0, pos), '\n');
+      const size_t line_start =
+          newline_before == StringPiece::npos ? 0 : newline_before + 1;
+      const size_t newline_after = rest.find('\n', pos);
+      const size_t line_end =
+          newline_after == StringPiece::npos ? rest.size() : newline_after + 1;
+      if (!Charge(i, rest.substr(0, line_end))) return false;
+      StringPiece line = rest.substr(line_start, line_end - line_start);
+      StringPiece captured;
+      if (profile_.empty() ? TryCheck(i, &line, &captured)
+                           : ProfileCheck(i, &line, &captured)) {
+        found = i;
+        found_captured = captured;
+        limit = from + line_start;
+        break;
+      }
+      from += line_end;
+    }
+  }
+  if (found == num_checks_) return true;
+  const Check& check = pattern_[found];
+  return Decide(Fail(found)
+                << InputNote(found_captured, false,
+                             "error: CHECK-NOT: string occurred!")
+                << CheckNote(check, "note: CHECK-NOT: pattern specified here")
+                << VarNotes(found_captured, false, check));
+}
+
+bool Matcher::Process(StringPiece text) {
+  StatsTimer timer(match_seconds());
+  return ProcessText(text);
+}
+
+bool Matcher::ProcessText(StringPiece text) {
+  if (decided_) return false;
+  // The previous text is about to be replaced.
+  Retain();
+
+  if (previous_in_retained_ && retained_lines_needed_ > 0) {
+    // This text starts with lines the retained text still lacks.
+    const size_t pos = size_t(previous_match_end_.data() - retained_.data());
+    for (Cursor cursor(text); retained_lines_needed_ > 0 && !cursor.Exhausted();
+         cursor.AdvanceLine()) {
+      const StringPiece line = cursor.RestOfLine();
+      retained_.append(line.data(), line.size());
+      --retained_lines_needed_;
+    }
+    previous_match_end_ =
+        StringPiece(retained_.data() + pos, previous_match_end_.size());
+  }
+  text_ = text;
+  base_offset_ = next_offset_;
+  base_line_num_ = next_line_num_;
+  base_cursor_line_num_ = next_cursor_line_num_;
+  next_offset_ += text.size();
+  text_lines_ = effcee::make_unique<LineIndex>(text);
+  // The text may reuse the storage of an earlier text.
+  group_scanner_.Forget();
+  // Poll for cancellation before the first try in each text.
+  bytes_since_poll_ = kPollBytes;
+
+  if (!started_) {
+    started_ = true;
+    previous_match_end_ = text.substr(0, 0);
+    previous_match_line_ = Cursor(text).RestOfLine();
+  }
+
+  // We think of the input string as a sequence of lines that can satisfy
+  // the checks.  Walk through the rules until no unsatisfied checks are left.
+  //
+  // The matching algorithm scans both the input and the pattern from start
+  // to finish.  At the start, all checks are unresolved.  We try to match
+  // each line in the input against the unresolved checks in a sliding window
+  // in the pattern.  When a positive check matches, we mark it as resolved.
+  // When a negative check matches, the algorithm terminates with failure.
+  // We mark a negative check as resolved when it is the earliest unresolved
+  // check and the first positive check after it is resolved.
+  //
+  // When the window starts with a run of negative checks followed by a
+  // positive check other than DAG, the negative checks are not tried line by
+  // line.  Instead, once the positive check matches, they are searched for
+  // over the range of lines since the previous positive match.  A range
+  // that reaches the end of the text is searched at the end of the text.
+  //
+  // Initially the pattern window is just the first element.
+  const CheckList& pattern = pattern_;
+  const size_t num_checks = num_checks_;
+
+  // Set up a cursor to scan the text.
+  Cursor cursor(text);
+
+  // Skips the lines that can't satisfy the current pass over the checks.
+  // When the first unresolved check is a positive check other than DAG, it
+  // is the only check tried against a line unless it matches there.  So
+  // search the rest of the text at once for the first literal it requires,
+  // and move to the line containing it.  The lines before it are left alone
+  // by the line-by-line scan anyway.  The same goes for the positive check
+  // after deferred negative checks, which are searched for later.
+  auto skip_to_candidate_line = [&]() {
+    while (first_check_ < num_checks && resolved_[first_check_]) {
+      ++first_check_;
+    }
+    if (first_check_ == num_checks) return;
+    const StringPiece rest = cursor.remaining();
+    const size_t target = defer_until_[first_check_];
+    if (target != first_check_ && !deferred_from_) {
+      deferred_from_ = rest.data();
+    }
+    if (target == num_checks) {
+      // Only deferred checks are left.  Move past the end.
+      cursor.AdvanceLinesBefore(rest.size()).AdvanceLine();
+      return;
+    }
+    const Check& check = pattern[target];
+    if (check.type() == Type::DAG || check.type() == Type::Not) return;
+    if (check.required_literals().empty()) return;
+    const size_t pos = FindLiteral(rest, check.required_literals()[0]);
+    if (pos == StringPiece::npos) {
+      // No line can match.  Move past the end.
+      cursor.AdvanceLinesBefore(rest.size()).AdvanceLine();
+    } else {
+      cursor.AdvanceLinesBefore(pos);
+    }
+  };
+
+  // A pass over the checks that was suspended at the end of the previous
+  // text resumes on the first line of this one, which continues the same
+  // line as far as the cursor is concerned.
+  bool resuming = suspended_;
+  suspended_ = false;
+  if (resuming && !resolved_[first_check_] &&
+      defer_until_[first_check_] != first_check_) {
+    deferred_from_ = text.data();
+  }
+
+  // For each line.
+  for (; resuming || !cursor.Exhausted(); cursor.AdvanceLine()) {
+    if (!resuming) {
+      skip_to_candidate_line();
+      if (cursor.Exhausted()) break;
+    }
+
+    // Try to match the current line against the unresolved checks.
+    const StringPiece line = cursor.RestOfLine();
+    const int line_num = InputLineNum(cursor);
+    line_num_ = line_num;
+    if (stats_ && !resuming) {
+      ++stats_->lines_scanned;
+      stats_->bytes_scanned += line.size();
+    }
+
+    // The number of characters the cursor should advance to accommodate a
+    // recent DAG check match.
+    size_t deferred_advance = 0;
+
+    bool scan_this_line = true;
+    while (scan_this_line) {
+      Pass pass;
+      if (resuming) {
+        pass = suspended_pass_;
+        resuming = false;
+      } else {
+        // Skip the initial segment of resolved checks.  Slides the left end
+        // of the pattern window toward the right.
+        while (first_check_ < num_checks && resolved_[first_check_]) {
+          ++first_check_;
+        }
+        // We've reached the end of the pattern.  Declare success.
+        if (first_check_ == num_checks) return Conclude();
+        if (sink_) TraceWindow(first_check_, line_num);
+        pass.next_check = first_check_;
+        pass.first_unresolved_dag = num_checks;
+        pass.first_unresolved_negative = num_checks;
+        pass.defer_until = defer_until_[first_check_];
+        pass.resolved_something = false;
+        pass.window_checks = 0;
+      }
+
+      for (size_t i = pass.next_check; i < num_checks; ++i) {
+        if (resolved_[i]) continue;
+
+        const Check& check = pattern[i];
+        if (check.type() != Type::DAG) {
+          cursor.Advance(deferred_advance);
+          deferred_advance = 0;
+        }
+        const StringPiece rest_of_line = cursor.RestOfLine();
+        if (cursor.Exhausted() && !text.empty() &&
+            text[text.size() - 1] == '\n') {
+          // A match consumed the newline ending the text, so the line goes
+          // on in the next text, if there is one.  Try the rest of the
+          // checks there.
+          pass.next_check = i;
+          suspended_pass_ = pass;
+          suspended_ = true;
+          break;
+        }
+        if (i < pass.defer_until) {
+          if (!deferred_from_) deferred_from_ = rest_of_line.data();
+          pass.first_unresolved_negative =
+              std::min(pass.first_unresolved_negative, i);
+          continue;
+        }
+
+        if (check.type() == Type::DAG || check.type() == Type::Not) {
+          ++pass.window_checks;
+        }
+        if (!Charge(i, rest_of_line)) return false;
+        StringPiece unconsumed = rest_of_line;
+        StringPiece captured;
+
+        if (profile_.empty() ? TryCheck(i, &unconsumed, &captured)
+                             : ProfileCheck(i, &unconsumed, &captured)) {
+          if (deferred_from_ && i == pass.defer_until) {
+            // The range of the deferred checks ends with this line.
+            const char* const line_end =
+                rest_of_line.data() + rest_of_line.size();
+            const StringPiece range(deferred_from_,
+                                    size_t(line_end - deferred_from_));
+            deferred_from_ = nullptr;
+            // Trying the deferred checks would replace this check's
+            // variable captures, which the trace needs.
+            VarCaptures var_captures;
+            var_captures.swap(var_captures_);
+            const bool passed = TryDeferredNots(first_check_, range);
+            var_captures.swap(var_captures_);
+            if (!passed) return false;
+          }
+
+          if (check.type() == Type::Not) {
+            return Decide(
+                Fail(i)
+                << InputNote(captured, false,
+                             "error: CHECK-NOT: string occurred!")
+                << CheckNote(check, "note: CHECK-NOT: pattern specified here")
+                << VarNotes(captured, false, check));
+          }
+
+          if (check.type() == Type::Same && line_num != matched_line_num_) {
+            return Decide(
+                Fail(i)
+                << CheckNote(check,
+                             "error: CHECK-SAME: is not on the same line as "
+                             "previous match")
+                << InputNote(captured, false, "note: 'next' match was here")
+                << PreviousMatchNote("note: previous match ended here"));
+          }
+
+          if (check.type() == Type::Next) {
+            if (line_num == matched_line_num_) {
+              return Decide(
+                  Fail(i)
+                  << CheckNote(check,
+                               "error: CHECK-NEXT: is on the same line as "
+                               "previous match")
+                  << InputNote(captured, false, "note: 'next' match was here")
+                  << PreviousMatchNote("note: previous match ended here")
+                  << VarNotes(previous_match_end_, previous_in_retained_,
+                              check));
+            }
+            if (line_num > 1 + matched_line_num_) {
+              // This must be valid since there was an intervening line.
+              const StringPiece previous_text =
+                  previous_in_retained_ ? StringPiece(retained_) : text;
+              const auto non_match =
+                  Cursor(previous_text)
+                      .Advance(previous_match_end_.data() -
+                               previous_text.data())
+                      .AdvanceLine()
+                      .RestOfLine();
+
+              return Decide(
+                  Fail(i)
+                  << CheckNote(check,
+                               "error: CHECK-NEXT: is not on the line after "
+                               "the previous match")
+                  << InputNote(captured, false, "note: 'next' match was here")
+                  << PreviousMatchNote("note: previous match ended here")
+                  << InputNote(non_match, previous_in_retained_,
+                               "note: non-matching line after previous "
+                               "match is here")
+                  << VarNotes(previous_match_end_, previous_in_retained_,
+                              check));
+            }
+          }
+
+          if (check.type() != Type::DAG && pass.first_unresolved_dag < i) {
+            return Decide(
+                Fail(pass.first_unresolved_dag)
+                << CheckNote(pattern[pass.first_unresolved_dag],
+                             "error: expected string not found in input")
+                << PreviousMatchNote("note: scanning from here")
+                << InputNote(captured, false, "note: next check matches here")
+                << VarNotes(previous_match_end_, previous_in_retained_,
+                            check));
+          }
+
+          resolved_[i] = true;
+          if (sink_) TraceCheck(i, line_num);
+          if (trace_matches_) {
+            auto& entry = trace_[i];
+            entry.matched = true;
+            entry.text = captured;
+            entry.offset = base_offset_ + size_t(captured.data() - text.data());
+            entry.line_num = line_num;
+            for (const auto& var_capture : var_captures_) {
+              entry.captures.push_back(
+                  {ToString(var_capture.first), var_capture.second,
+                   base_offset_ +
+                       size_t(var_capture.second.data() - text.data())});
+            }
+          }
+          matched_line_num_ = line_num;
+          previous_match_end_ = unconsumed;
+          previous_in_retained_ = false;
+          // The input line holding the end of the match.  A match may have
+          // consumed newlines, so this need not be |line|.
+          const char* const line_end =
+              rest_of_line.data() + rest_of_line.size();
+          const char* line_start = rest_of_line.data();
+          if (line_end == line.data() + line.size()) {
+            line_start = line.data();
+          } else {
+            while (line_start > text.data() && line_start[-1] != '\n') {
+              --line_start;
+            }
+          }
+          previous_match_line_ =
+              StringPiece(line_start, size_t(line_end - line_start));
+          pass.resolved_something = true;
+
+          // Resolve any prior negative checks that precede an unresolved DAG.
+          for (auto j = pass.first_unresolved_negative,
+                    limit = std::min(pass.first_unresolved_dag, i);
+               j < limit; ++j) {
+            resolved_[j] = true;
+          }
+
+          // Normally advance past the matched text.  But DAG checks might need
+          // to match out of order on the same line.  So only advance for
+          // non-DAG cases.
+
+          const size_t advance_proposal =
+              rest_of_line.size() - unconsumed.size();
+          if (check.type() == Type::DAG) {
+            deferred_advance = std::max(deferred_advance, advance_proposal);
+          } else {
+            cursor.Advance(advance_proposal);
+          }
+
+        } else {
+          // This line did not match the check.
+          if (check.type() == Type::Not) {
+            pass.first_unresolved_negative =
+                std::min(pass.first_unresolved_negative, i);
+            // An unresolved Not check stops the search for more DAG checks.
+            if (pass.first_unresolved_dag < num_checks) i = num_checks;
+          } else if (check.type() == Type::DAG) {
+            pass.first_unresolved_dag = std::min(pass.first_unresolved_dag, i);
+          } else {
+            // An unresolved non-DAG check check stops this pass over the
+            // checks.
+            i = num_checks;
+          }
+        }
+      }
+      if (suspended_) break;
+      if (stats_) {
+        stats_->window_checks += pass.window_checks;
+        stats_->max_window_checks =
+            std::max(stats_->max_window_checks, pass.window_checks);
+      }
+      scan_this_line = pass.resolved_something;
+    }
+  }
+  next_cursor_line_num_ = InputLineNum(cursor);
+  // A match may have consumed newlines without the cursor counting them.
+  next_line_num_ =
+      base_line_num_ + int(std::count(text.begin(), text.end(), '\n'));
+  if (deferred_from_) {
+    // The range of the deferred checks continues into the next text.
+    const StringPiece range(deferred_from_,
+                            size_t(text.data() + text.size() - deferred_from_));
+    deferred_from_ = nullptr;
+    if (!TryDeferredNots(first_check_, range)) return false;
+  }
+  return true;
+}
+
+bool Matcher::Feed(StringPiece chunk) {
+  if (decided_) return false;
+  StatsTimer timer(match_seconds());
+  const size_t last_newline = FindLastChar(chunk, '\n');
+  if (last_newline == StringPiece::npos) {
+    partial_line_.append(chunk.data(), chunk.size());
+    return true;
+  }
+  // Complete the partial line, and match it on its own.
+  size_t start = 0;
+  if (!partial_line_.empty()) {
+    start = chunk.find('\n') + 1;
+    partial_line_.append(chunk.data(), start);
+    if (!ProcessText(partial_line_)) return false;
+  }
+  // Match the complete lines left in the chunk.
+  const size_t end = last_newline + 1;
+  if (start < end && !ProcessText(chunk.substr(start, end - start))) {
+    return false;
+  }
+  // Neither the chunk nor the partial line is kept.
+  Retain();
+  partial_line_.assign(chunk.data() + end, chunk.size() - end);
+  return true;
+}
+
+bool Matcher::Conclude() {
+  // Fail if there are any unresolved positive checks.
+  for (auto i = first_check_; i < num_checks_; ++i) {
+    if (resolved_[i]) continue;
+    const Check& check = pattern_[i];
+    if (check.type() == Type::Not) continue;
+
+    return Decide(Fail(i)
+                  << CheckNote(check,
+                               "error: expected string not found in input")
+                  << PreviousMatchNote("note: scanning from here")
+                  << VarNotes(previous_match_end_, previous_in_retained_,
+                              check));
+  }
+
+  Result result(Status::Ok);
+  if (trace_matches_) result.SetTrace(std::move(trace_));
+  return Decide(std::move(result));
+}
+
+Result Matcher::Finish() {
+  {
+    StatsTimer timer(match_seconds());
+    if (!started_ || suspended_ || !partial_line_.empty()) {
+      ProcessText(partial_line_);
+    }
+    if (!decided_) Conclude();
+  }
+  if (program_.options().collect_stats()) result_.SetStats(*stats_);
+  if (!profile_.empty()) result_.SetProfile(profile_);
+  return result_;
+}
+
+}  // namespace effcee
@@ -0,0 +1,318 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_MATCHER_H
+#define EFFCEE_MATCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "cursor.h"
+#include "diagnostic.h"
+#include "effcee.h"
+#include "group_filter.h"
+#include "program.h"
+#include "stats.h"
+#include "to_string.h"
+
+namespace effcee {
+
+// The state of a match of a program against an input.  The input is given
+// as a sequence of texts, each holding whole lines of the input, except
+// that the last text may end without a newline.
+//
+// Only the most recent text is used, so each text may be discarded after
+// the next one is processed, or after Retain() is called.  Retain() keeps
+// copies of the values of variables, and of the lines needed to describe a
+// failure.
+class Matcher {
+ public:
+  // Starts a match against the given program, which must have been parsed
+  // successfully.  If |trace| is true, then a successful match records
+  // where each check matched.  The trace refers to the processed texts.
+  // Statistics are collected, and the checks profiled, if the program's
+  // options ask for them.
+  Matcher(const Program::Impl& program, bool trace);
+
+  Matcher(const Matcher&) = delete;
+  Matcher& operator=(const Matcher&) = delete;
+
+  // Matches the lines of |text|, which is the next part of the input.
+  // Returns false if the outcome of the match has been decided, in which
+  // case later texts are ignored.
+  bool Process(StringPiece text);
+
+  // Matches the complete lines of the input that |chunk| completes.  Keeps
+  // a copy of the incomplete line at the end of the chunk, if any, and
+  // calls Retain(), so the chunk may be discarded afterward.  Returns false
+  // if the outcome of the match has been decided.
+  bool Feed(StringPiece chunk);
+
+  // Sets the input name used in diagnostics, overriding the one in the
+  // program's options.
+  void SetInputName(StringPiece name) { input_name_ = ToString(name); }
+
+  // Returns true if the outcome of the match has been decided.
+  bool decided() const { return decided_; }
+
+  // Copies the parts of the most recent text that may be needed later: the
+  // values of variables, and the lines needed to describe a failure.
+  // Afterward that text may be discarded.
+  void Retain();
+
+  // Returns the result of the match, given that no more input follows.
+  // First matches the incomplete line kept by Feed(), if any.  The most
+  // recent text must still be valid unless Retain() was called.
+  Result Finish();
+
+ private:
+  // Implements Process(), without timing it.
+  bool ProcessText(StringPiece text);
+  // Returns true if check |i| matches a prefix of |*text|, which is the
+  // rest of the current line.  On success, advances |*text| past the match
+  // and sets |*captured| to the text matched by the check's pattern.
+  bool TryCheck(size_t i, StringPiece* text, StringPiece* captured);
+  // Like TryCheck, but also adds the cost of the attempt to the profile.
+  bool ProfileCheck(size_t i, StringPiece* text, StringPiece* captured);
+  // Returns check |i|'s search of |text| for where it might match, adding
+  // the cost to the profile if there is one.  See Check::Search.
+  size_t SearchCheck(size_t i, StringPiece text);
+  // Charges trying check |i| against |text| to the scan budget, and now and
+  // then polls for cancellation.  Returns false if the match must stop, in
+  // which case its outcome has been decided.
+  bool Charge(size_t i, StringPiece text);
+  // Tries the deferred run of NOT checks starting at |first| against each
+  // line of |range|, as the line-by-line scan would have.  The first line
+  // of the range starts where the checks would first have been tried.
+  // Returns false if one of them matches, in which case the outcome has
+  // been decided.  The match reported is on the earliest line, and is of
+  // the first check to match there.
+  bool TryDeferredNots(size_t first, StringPiece range);
+
+  // Returns the error message for stopping the match early, if its
+  // cancellation token is cancelled or its deadline has passed.  Otherwise
+  // returns null.
+  const char* StopReason() const;
+
+  // Returns the line of the check rules holding |check|, without its line
+  // ending.
+  StringPiece RuleLine(const Check& check) const;
+  // Records a trace event for the resolution of positive check |i|, which
+  // matched on input line |line_num|.
+  void TraceCheck(size_t i, int line_num);
+  // Records a trace event for the window of DAG and NOT checks that has
+  // been left, if any, and starts tracing the one beginning at
+  // |first_check|, if any.  The window changes while the current input line
+  // is |line_num|.
+  void TraceWindow(size_t first_check, int line_num);
+
+  // Returns the location to add the match time to, or null if statistics
+  // are not collected.
+  double* match_seconds() const {
+    return stats_ ? &stats_->match_seconds : nullptr;
+  }
+
+  // Records the outcome of the match, and returns false.
+  bool Decide(Result result);
+  // Decides the outcome of the match, given that no input is left to
+  // resolve more checks.  Returns false.
+  bool Conclude();
+
+  // Returns the line number of the input corresponding to the line number
+  // of a cursor over the current text.  This is the line number a cursor
+  // over the whole input would have, which does not count the newlines
+  // consumed by matches.
+  int InputLineNum(const Cursor& cursor) const {
+    return base_cursor_line_num_ + cursor.line_num() - 1;
+  }
+
+  // The state of a pass over the checks, trying them against the rest of a
+  // line.
+  struct Pass {
+    // The next check to try.
+    size_t next_check;
+    // The first DAG and NOT checks that did not match in this pass, or the
+    // number of checks if there are none.
+    size_t first_unresolved_dag;
+    size_t first_unresolved_negative;
+    // The checks from the first unresolved one up to this one are deferred
+    // NOT checks, if any.
+    size_t defer_until;
+    // True if a check was resolved in this pass.
+    bool resolved_something;
+    // The number of DAG and NOT checks tried in this pass.
+    size_t window_checks;
+  };
+
+  // Returns a diagnostic for a failure to satisfy the check at
+  // |check_index|, with the given status.  Notes are added to it with
+  // operator<<.  The time until the failure is decided counts as diagnostic
+  // time.
+  Diagnostic Fail(size_t check_index,
+                  Result::Status status = Result::Status::Fail) const;
+  // Returns a note pointing at the parameter of a check rule.
+  Result::Note CheckNote(const Check& check, const char* message) const;
+  // Returns a note pointing at a position in the current text, or in the
+  // retained text if |retained| is true.  The note includes the full line
+  // containing the position.
+  Result::Note InputNote(StringPiece where, bool retained,
+                         std::string message) const;
+  // Returns a note pointing at the end of the previous positive match.
+  Result::Note PreviousMatchNote(std::string message) const {
+    return InputNote(previous_match_end_, previous_in_retained_,
+                     std::move(message));
+  }
+  // Returns notes describing the value of each variable use in the given
+  // check, in the context of the |where| portion of the input line.
+  VariableNotes VarNotes(StringPiece where, bool retained,
+                         const Check& check) const;
+
+  const Program::Impl& program_;
+  const CheckList& pattern_;
+  const size_t num_checks_;
+  // The input name used in diagnostics.
+  std::string input_name_;
+
+  // The statistics of the parse and match so far, or null if they are not
+  // collected.  They are also collected for the profile, which uses the
+  // regex counts.
+  std::unique_ptr<MatchStats> stats_;
+  // The cost of each check, if the match is profiled.  Otherwise empty.
+  std::vector<Result::CheckProfile> profile_;
+
+  // Receives trace events, or null if the match is not traced that way.
+  TraceEventSink* const sink_;
+  // When the match started.
+  const StatsClock::time_point match_start_;
+  // When the search for the next positive check started, and the input
+  // line it started on.
+  StatsClock::time_point search_start_;
+  int search_start_line_;
+  // The first check of the DAG and NOT window being traced, or the number
+  // of checks if there is none, and when and on which input line the
+  // window started.
+  size_t window_check_;
+  StatsClock::time_point window_start_;
+  int window_start_line_;
+  // The input line being matched.
+  int line_num_;
+  // When the failure being described started to be described.
+  mutable StatsClock::time_point diagnostic_start_;
+
+  // The values of variables, by slot.  This is updated when a check rule
+  // matches a variable definition.  Values refer to the current text until
+  // Retain() copies them.
+  VarMapping vars_;
+
+  // The most input bytes the checks may be tried against, or 0 for no
+  // limit, and the number tried so far.
+  const size_t scan_budget_;
+  size_t bytes_tried_;
+
+  // The token that can cancel the match, or null, and the time by which it
+  // must end.
+  const CancellationToken* const cancellation_token_;
+  const bool has_deadline_;
+  const StatsClock::time_point deadline_;
+  // The input bytes tried since the token and deadline were last polled.
+  size_t bytes_since_poll_;
+
+  // What checks are resolved?  Entry |i| is true when check |i| in the
+  // pattern is resolved.
+  std::vector<bool> resolved_;
+
+  // |first_check_| is the first unresolved check.
+  size_t first_check_;
+
+  // A run of NOT checks followed by a positive check other than DAG, or by
+  // the end of the checks, need not be tried line by line.  They are tried
+  // once the range of input between the positive matches around them is
+  // known.  Entry |i| is the index of the check after the run, for a check
+  // in such a run.  Otherwise it is |i|.  A run is not deferred when the
+  // check after it, or a check in the run, defines a variable that a later
+  // check in the run uses.
+  std::vector<size_t> defer_until_;
+  // Where in the current text the deferred NOT checks starting at
+  // |first_check_| would first have been tried, or null if no checks are
+  // deferred.
+  const char* deferred_from_;
+
+  // The 1-based line number of the most recent successful match.
+  int matched_line_num_;
+
+  // Rules out DAG and NOT checks that can't match the current line.
+  GroupFilter::Scanner group_scanner_;
+
+  // Where each check matched, if the match is traced.
+  const bool trace_matches_;
+  std::vector<Result::CheckMatch> trace_;
+  VarCaptures var_captures_;
+
+  // True once the first text has been processed.
+  bool started_;
+
+  // The most recent text, and the position of its start in the input.
+  StringPiece text_;
+  size_t base_offset_;
+  int base_line_num_;
+  // Indexes the lines of |text_| for diagnostics.  Built on demand.
+  std::unique_ptr<LineIndex> text_lines_;
+
+  // The position in the input of the start of the next text, and its line
+  // number.
+  size_t next_offset_;
+  int next_line_num_;
+  // The line numbers that a cursor over the whole input would give the
+  // first lines of the most recent text and of the next one.
+  int base_cursor_line_num_;
+  int next_cursor_line_num_;
+
+  // True if a match consumed the newline ending the most recent text in
+  // the middle of a pass over the checks.  The pass resumes on the first
+  // line of the next text, or on an empty line if no text follows.
+  bool suspended_;
+  Pass suspended_pass_;
+
+  // Points to the end of the previous positive match.  This is in |text_|,
+  // or in |retained_| if |previous_in_retained_| is true.  Before the first
+  // match, it is the start of the input.
+  StringPiece previous_match_end_;
+  bool previous_in_retained_;
+  // The full line containing |previous_match_end_|, when that is in |text_|.
+  StringPiece previous_match_line_;
+
+  // Copies of the line containing the end of the previous positive match,
+  // and of the lines after it a note may describe as far as they have been
+  // seen, and the position of the first of them in the input.
+  std::string retained_;
+  size_t retained_offset_;
+  int retained_line_num_;
+  // The number of lines from the next texts that |retained_| still lacks.
+  int retained_lines_needed_;
+  // A copy of the last line of the text before the most recent one.
+  std::string previous_text_last_line_;
+
+  // The last line passed to Feed(), if it is not yet complete.
+  std::string partial_line_;
+
+  // True when the outcome is decided, which is then in |result_|.
+  bool decided_;
+  Result result_;
+};
+
+}  // namespace effcee
+
+#endif
@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 
 #include "effcee.h"
@@ -63,6 +68,38 @@ TEST(Options, SetPrefixTwiceRetainsLastPrefix) {
   EXPECT_THAT(options.prefix(), Eq("bar baz"));
 }
 
+TEST(Options, DefaultPrefixesAreCHECK) {
+  EXPECT_THAT(Options().prefixes(), Eq(std::vector<std::string>{"CHECK"}));
+}
+
+TEST(Options, SetPrefixesReturnsSelf) {
+  Options options;
+  const Options& other = options.SetPrefixes({"A", "B"});
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(Options, SetPrefixesSetsPrefixes) {
+  Options options;
+  options.SetPrefixes({"foo", "bar"});
+  EXPECT_THAT(options.prefixes(),
+              Eq(std::vector<std::string>{"foo", "bar"}));
+  EXPECT_THAT(options.prefix(), Eq("foo"));
+}
+
+TEST(Options, SetPrefixesEmptyListIsOneEmptyPrefix) {
+  Options options;
+  options.SetPrefixes({});
+  EXPECT_THAT(options.prefixes(), Eq(std::vector<std::string>{""}));
+  EXPECT_THAT(options.prefix(), Eq(""));
+}
+
+TEST(Options, SetPrefixReplacesPrefixes) {
+  Options options;
+  options.SetPrefixes({"foo", "bar"});
+  options.SetPrefix("baz");
+  EXPECT_THAT(options.prefixes(), Eq(std::vector<std::string>{"baz"}));
+}
+
 
 // Input name property
 
@@ -140,4 +177,105 @@ TEST(Options, SetChecksNameTwiceRetainsLastChecksName) {
   EXPECT_THAT(options.checks_name(), Eq("bar baz"));
 }
 
+// Match trace property
+
+TEST(Options, DefaultTraceMatchesIsFalse) {
+  EXPECT_THAT(Options().trace_matches(), Eq(false));
+}
+
+TEST(Options, SetTraceMatchesReturnsSelf) {
+  Options options;
+  const Options& other = options.SetTraceMatches(true);
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(Options, SetTraceMatchesSetsTraceMatches) {
+  Options options;
+  options.SetTraceMatches(true);
+  EXPECT_THAT(options.trace_matches(), Eq(true));
+  options.SetTraceMatches(false);
+  EXPECT_THAT(options.trace_matches(), Eq(false));
+}
+
+// Statistics property
+
+TEST(Options, DefaultCollectStatsIsFalse) {
+  EXPECT_THAT(Options().collect_stats(), Eq(false));
+}
+
+TEST(Options, SetCollectStatsReturnsSelf) {
+  Options options;
+  const Options& other = options.SetCollectStats(true);
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(Options, SetCollectStatsSetsCollectStats) {
+  Options options;
+  options.SetCollectStats(true);
+  EXPECT_THAT(options.collect_stats(), Eq(true));
+  options.SetCollectStats(false);
+  EXPECT_THAT(options.collect_stats(), Eq(false));
+}
+
+// Resource limit properties
+
+TEST(Options, DefaultRegexMaxMemIsZero) {
+  EXPECT_THAT(Options().regex_max_mem(), Eq(0));
+}
+
+TEST(Options, SetRegexMaxMemReturnsSelf) {
+  Options options;
+  const Options& other = options.SetRegexMaxMem(1 << 20);
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(Options, SetRegexMaxMemSetsRegexMaxMem) {
+  Options options;
+  options.SetRegexMaxMem(1 << 20);
+  EXPECT_THAT(options.regex_max_mem(), Eq(1 << 20));
+}
+
+TEST(Options, DefaultScanBudgetIsZero) {
+  EXPECT_THAT(Options().scan_budget(), Eq(0u));
+}
+
+TEST(Options, SetScanBudgetReturnsSelf) {
+  Options options;
+  const Options& other = options.SetScanBudget(1000);
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(Options, SetScanBudgetSetsScanBudget) {
+  Options options;
+  options.SetScanBudget(1000);
+  EXPECT_THAT(options.scan_budget(), Eq(1000u));
+}
+
+// Deadline and cancellation properties
+
+TEST(Options, NoDeadlineByDefault) {
+  EXPECT_FALSE(Options().has_deadline());
+}
+
+TEST(Options, SetDeadlineSetsDeadline) {
+  const auto deadline = std::chrono::steady_clock::now();
+  Options options;
+  const Options& other = options.SetDeadline(deadline);
+  EXPECT_THAT(&other, &options);
+  EXPECT_TRUE(options.has_deadline());
+  EXPECT_TRUE(options.deadline() == deadline);
+}
+
+TEST(Options, NoCancellationTokenByDefault) {
+  EXPECT_THAT(Options().cancellation_token(), Eq(nullptr));
+}
+
+TEST(Options, SetCancellationTokenSetsToken) {
+  auto token = std::make_shared<effcee::CancellationToken>();
+  Options options;
+  const Options& other = options.SetCancellationToken(token);
+  EXPECT_THAT(&other, &options);
+  EXPECT_THAT(options.cancellation_token(), Eq(token.get()));
+}
+
 }  // namespace
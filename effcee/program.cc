@@ -0,0 +1,69 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "program.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "check.h"
+#include "effcee.h"
+#include "group_filter.h"
+#include "make_unique.h"
+#include "stats.h"
+#include "to_string.h"
+
+namespace effcee {
+
+Program::Impl::Impl(StringPiece checks, const Options& options, Use use)
+    : checks_storage_(use == Use::Reusable ? ToString(checks) : std::string()),
+      options_storage_(use == Use::Reusable ? options : Options()),
+      checks_(use == Use::Reusable ? StringPiece(checks_storage_) : checks),
+      checks_lines_(checks_),
+      options_(use == Use::Reusable ? options_storage_ : options),
+      parse_result_(Result::Status::Ok) {
+  MatchStats* stats = options_.collect_stats() ? &parse_stats_ : nullptr;
+  {
+    StatsTimer timer(stats ? &parse_stats_.parse_seconds : nullptr);
+    TraceSpan span(options_.trace_event_sink(), "ParseChecks", "parse");
+    span.AddArg("checks", options_.checks_name());
+    auto parsed = ParseChecks(checks_, options_, stats);
+    parse_result_ = parsed.first;
+    check_list_ = std::move(parsed.second);
+    span.AddArg("rules", std::to_string(check_list_.size()));
+    if (use == Use::Once) {
+      group_filter_ =
+          effcee::make_unique<const GroupFilter>(check_list_.size());
+    } else {
+      TraceSpan filter_span(options_.trace_event_sink(), "CompileRegexSets",
+                            "parse");
+      group_filter_ = effcee::make_unique<const GroupFilter>(
+          check_list_, options_.regex_max_mem());
+      filter_span.AddArg("sets", std::to_string(group_filter_->num_sets()));
+    }
+  }
+  if (stats) {
+    // Each set in the filter is compiled once.
+    parse_stats_.regexes_compiled += group_filter_->num_sets();
+    parse_result_.SetStats(parse_stats_);
+  }
+}
+
+Program::Program(StringPiece checks, const Options& options)
+    : impl_(std::make_shared<const Impl>(checks, options)) {}
+
+const Result& Program::compile_result() const { return impl_->parse_result(); }
+
+}  // namespace effcee
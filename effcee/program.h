@@ -0,0 +1,83 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_PROGRAM_H
+#define EFFCEE_PROGRAM_H
+
+#include <memory>
+#include <string>
+
+#include "check.h"
+#include "cursor.h"
+#include "effcee.h"
+#include "group_filter.h"
+
+namespace effcee {
+
+// The parsed form of a check program.  The parsed checks refer into the text
+// of the check rules.  It is not modified after construction.
+class Program::Impl {
+ public:
+  // How a program is used.
+  enum class Use {
+    // Matched any number of times.  The program keeps copies of the check
+    // rules and options, and builds the filter for DAG and NOT checks.
+    Reusable,
+    // Matched once, while the check rules and options passed to the
+    // constructor are alive.  Building the filter would cost more than it
+    // saves, so every check is tried.
+    Once,
+  };
+
+  // Parses |checks| with the given |options|.
+  Impl(StringPiece checks, const Options& options, Use use = Use::Reusable);
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  // Accessors.
+  StringPiece checks() const { return checks_; }
+  const LineIndex& checks_lines() const { return checks_lines_; }
+  const Options& options() const { return options_; }
+  const Result& parse_result() const { return parse_result_; }
+  const CheckList& check_list() const { return check_list_; }
+  const GroupFilter& group_filter() const { return *group_filter_; }
+  // The statistics of the parse.  They are only collected if the options
+  // ask for them.
+  const MatchStats& parse_stats() const { return parse_stats_; }
+
+ private:
+  // Copies of the check rules and options, for a reusable program.
+  const std::string checks_storage_;
+  const Options options_storage_;
+  // The text of the check rules.  The checks in |check_list_| refer into
+  // this text.
+  const StringPiece checks_;
+  // An index of the lines in |checks_|, for diagnostics.
+  const LineIndex checks_lines_;
+  // The options used to parse the checks, and later to match.
+  const Options& options_;
+  // The result of parsing the checks.
+  Result parse_result_;
+  // The parsed checks.  This is empty if parsing failed.
+  CheckList check_list_;
+  // Prefilters the DAG and NOT checks in |check_list_|.
+  std::unique_ptr<const GroupFilter> group_filter_;
+  // The work done to parse the checks and build the filter.
+  MatchStats parse_stats_;
+};
+
+}  // namespace effcee
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+
+#include "effcee.h"
+
+namespace {
+
+using effcee::Options;
+using effcee::Program;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Ne;
+
+using Status = effcee::Result::Status;
+
+// Program class
+
+TEST(Program, CompileResultIsOkForValidChecks) {
+  Program program("CHECK: Hello");
+  EXPECT_THAT(program.compile_result().status(), Eq(Status::Ok));
+  EXPECT_TRUE(program);
+}
+
+TEST(Program, CompileResultIsNoRulesWhenChecksAbsent) {
+  Program program("no checks here");
+  EXPECT_THAT(program.compile_result().status(), Eq(Status::NoRules));
+  EXPECT_FALSE(program);
+}
+
+TEST(Program, CompileResultIsBadOptionForEmptyPrefix) {
+  Program program("CHECK: Hello", Options().SetPrefix(""));
+  EXPECT_THAT(program.compile_result().status(), Eq(Status::BadOption));
+}
+
+TEST(Program, MatchReturnsCompileFailure) {
+  Program program("CHECK: {{\\}}");
+  const auto result = program.Match("anything");
+  EXPECT_THAT(result.status(), Eq(Status::BadRule));
+  EXPECT_THAT(result.message(), HasSubstr("invalid regex"));
+}
+
+TEST(Program, MatchPasses) {
+  Program program("CHECK: Hello\nCHECK-NEXT: World");
+  const auto result = program.Match("Hello\nWorld");
+  EXPECT_TRUE(result) << result.message();
+}
+
+TEST(Program, MatchFails) {
+  Program program("CHECK: Hello\nCHECK-NEXT: World");
+  const auto result = program.Match("Hello\n\nWorld");
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.status(), Eq(Status::Fail));
+}
+
+TEST(Program, MatchSeveralInputs) {
+  Program program("CHECK: [[X:[0-9]+]]\nCHECK-SAME: [[X]]");
+  EXPECT_TRUE(program.Match("12 12"));
+  EXPECT_FALSE(program.Match("12 13"));
+  // Variable values do not leak from one match to the next.
+  EXPECT_TRUE(program.Match("13 13"));
+}
+
+TEST(Program, KeepsCopyOfChecks) {
+  std::string checks("CHECK: Hello");
+  Program program(checks);
+  checks.assign(checks.size(), 'z');
+  const auto result = program.Match("Hello");
+  EXPECT_TRUE(result) << result.message();
+}
+
+TEST(Program, KeepsCopyOfOptions) {
+  Options options;
+  options.SetPrefix("FOO").SetInputName("in");
+  Program program("FOO: Hello", options);
+  options.SetPrefix("BAR").SetInputName("other");
+  const auto result = program.Match("World");
+  EXPECT_FALSE(result);
+  EXPECT_THAT(result.message(), HasSubstr("in:1:1:"));
+  EXPECT_THAT(result.message(), HasSubstr("FOO: Hello"));
+}
+
+TEST(Program, CopiesMatchTheSame) {
+  Program original("CHECK: Hello");
+  Program copy(original);
+  EXPECT_TRUE(copy.Match("Hello"));
+  EXPECT_FALSE(copy.Match("World"));
+}
+
+// Statistics
+
+TEST(Program, StatsAreNotCollectedByDefault) {
+  Program program("CHECK: Hello");
+  EXPECT_THAT(program.compile_result().stats(), Eq(nullptr));
+  EXPECT_THAT(program.Match("Hello").stats(), Eq(nullptr));
+}
+
+TEST(Program, CompileResultHasParseStats) {
+  Program program("CHECK: {{H+}}ello", Options().SetCollectStats(true));
+  const auto* stats = program.compile_result().stats();
+  ASSERT_THAT(stats, Ne(nullptr));
+  // The regex part, and the regex for the whole check.
+  EXPECT_THAT(stats->regexes_compiled, Eq(2u));
+  EXPECT_THAT(stats->regex_matches, Eq(0u));
+  EXPECT_THAT(stats->lines_scanned, Eq(0u));
+  EXPECT_THAT(stats->parse_seconds, Ge(0.0));
+  EXPECT_THAT(stats->match_seconds, Eq(0.0));
+}
+
+TEST(Program, MatchStatsCountWork) {
+  Program program(
+      "CHECK: a\nCHECK-DAG: [[X:b+]]\nCHECK-NOT: {{c+}}\nCHECK: d [[X]]",
+      Options().SetCollectStats(true));
+  const auto result = program.Match("a\nbb\nd bb\n");
+  ASSERT_TRUE(result);
+  const auto* parse_stats = program.compile_result().stats();
+  const auto* stats = result.stats();
+  ASSERT_THAT(stats, Ne(nullptr));
+  // The last check uses a variable, so its regex is compiled when matching.
+  EXPECT_THAT(stats->regexes_compiled, Eq(parse_stats->regexes_compiled + 1));
+  EXPECT_THAT(stats->regex_matches, Gt(0u));
+  EXPECT_THAT(stats->lines_scanned, Eq(3u));
+  EXPECT_THAT(stats->bytes_scanned, Eq(10u));
+  EXPECT_THAT(stats->window_checks, Gt(0u));
+  EXPECT_THAT(stats->max_window_checks, Eq(2u));
+  EXPECT_THAT(stats->var_definitions, Eq(1u));
+  EXPECT_THAT(stats->parse_seconds, Eq(parse_stats->parse_seconds));
+  EXPECT_THAT(stats->match_seconds, Ge(0.0));
+  EXPECT_THAT(stats->diagnostic_seconds, Eq(0.0));
+}
+
+TEST(Program, MatchStatsCountLiteralMatchesOnlyWhenRegexRuns) {
+  Program program("CHECK: hello", Options().SetCollectStats(true));
+  // Substring search finds the literal, and an ASCII prefix is checked
+  // without a regex.
+  const auto ascii = program.Match("say hello\n");
+  ASSERT_TRUE(ascii);
+  EXPECT_THAT(ascii.stats()->regex_matches, Eq(0u));
+  // A prefix that is not ASCII is checked with a regex.
+  const auto utf8 = program.Match("caf\xc3\xa9 hello\n");
+  ASSERT_TRUE(utf8);
+  EXPECT_THAT(utf8.stats()->regex_matches, Eq(1u));
+}
+
+// Check profile
+
+TEST(Program, ProfileIsEmptyByDefault) {
+  Program program("CHECK: Hello");
+  EXPECT_THAT(program.Match("Hello").profile(), IsEmpty());
+  EXPECT_THAT(program.Match("Hello").ProfileReport(), Eq(""));
+}
+
+TEST(Program, ProfileHasEntryForEachCheck) {
+  Program program("CHECK: a\n  CHECK-NOT: {{x+}}\r\nCHECK: z",
+                  Options().SetProfileChecks(true));
+  const auto result = program.Match("a\nb\nc\nz\n");
+  ASSERT_TRUE(result);
+  EXPECT_THAT(result.stats(), Eq(nullptr));
+  const auto& profile = result.profile();
+  ASSERT_THAT(profile.size(), Eq(3u));
+
+  EXPECT_THAT(profile[1].check_index, Eq(1u));
+  EXPECT_THAT(profile[1].line_num, Eq(2));
+  EXPECT_THAT(profile[1].column, Eq(14));
+  EXPECT_THAT(profile[1].rule, Eq("  CHECK-NOT: {{x+}}"));
+  EXPECT_THAT(profile[1].seconds, Ge(0.0));
+  // The CHECK-NOT is tried against the rest of line 1 after the first check
+  // matches there.  From then on it is deferred, and searched for once over
+  // the lines up to the match of the last check.  No line holds a candidate
+  // match, so no other line is tried.
+  EXPECT_THAT(profile[1].lines_probed, Eq(1u));
+  EXPECT_THAT(profile[1].match_attempts, Eq(1u));
+  EXPECT_THAT(profile[1].regex_matches, Eq(2u));
+  // The last check is tried twice against line 1, before and after the first
+  // check matches there.  Then substring search finds it on line 4, without
+  // running a regex.
+  EXPECT_THAT(profile[2].lines_probed, Eq(3u));
+  EXPECT_THAT(profile[2].regex_matches, Eq(0u));
+}
+
+TEST(Program, ProfileReportListsTopRulesByTime) {
+  Program program("CHECK: a\nCHECK-NOT: {{x+}}\nCHECK: z",
+                  Options().SetProfileChecks(true));
+  auto result = program.Match("a\nb\nz\n");
+  auto profile = result.profile();
+  profile[0].seconds = 0.002;
+  profile[1].seconds = 0.003;
+  profile[2].seconds = 0.001;
+  result.SetProfile(profile);
+  EXPECT_THAT(result.ProfileReport(2),
+              Eq("2:12: 3.000 ms, 1 lines probed, 1 match attempts, "
+                 "2 regex runs: CHECK-NOT: {{x+}}\n"
+                 "1:8: 2.000 ms, 1 lines probed, 1 match attempts, "
+                 "0 regex runs: CHECK: a\n"));
+}
+
+TEST(Program, MatchStatsOfFailureIncludeDiagnosticTime) {
+  Program program("CHECK: a\nCHECK: b", Options().SetCollectStats(true));
+  const auto result = program.Match("a\nc\n");
+  ASSERT_FALSE(result);
+  const auto* stats = result.stats();
+  ASSERT_THAT(stats, Ne(nullptr));
+  EXPECT_THAT(stats->diagnostic_seconds, Ge(0.0));
+  EXPECT_THAT(stats->match_seconds, Ge(stats->diagnostic_seconds));
+}
+
+}  // namespace
@@ -0,0 +1,89 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cursor.h"
+#include "effcee.h"
+
+namespace effcee {
+
+class Result::FailureDetail {
+ public:
+  explicit FailureDetail(Failure failure) : failure_(std::move(failure)) {}
+
+  const Failure& failure() const { return failure_; }
+
+  // Returns the message for the failure, rendering it on first use.
+  const std::string& message() const {
+    std::call_once(rendered_, [this]() {
+      for (const auto& note : failure_.notes) {
+        message_ += note.source == Note::Source::Input ? failure_.input_name
+                                                       : failure_.checks_name;
+        message_ += LineMessage(note.line_num, note.line,
+                                size_t(note.column - 1), note.message);
+      }
+    });
+    return message_;
+  }
+
+ private:
+  const Failure failure_;
+  // Guards rendering the message.
+  mutable std::once_flag rendered_;
+  mutable std::string message_;
+};
+
+Result::Result(Status status, Failure failure)
+    : status_(status),
+      failure_(std::make_shared<const FailureDetail>(std::move(failure))),
+      render_failure_(true) {}
+
+const std::string& Result::message() const {
+  return render_failure_ ? failure_->message() : message_;
+}
+
+const Result::Failure* Result::failure() const {
+  return failure_ ? &failure_->failure() : nullptr;
+}
+
+std::string Result::ProfileReport(size_t top_n) const {
+  std::vector<const CheckProfile*> rules;
+  for (const auto& entry : profile_) rules.push_back(&entry);
+  top_n = std::min(top_n, rules.size());
+  std::partial_sort(rules.begin(), rules.begin() + top_n, rules.end(),
+                    [](const CheckProfile* a, const CheckProfile* b) {
+                      return a->seconds > b->seconds;
+                    });
+  std::ostringstream report;
+  report << std::fixed << std::setprecision(3);
+  for (size_t i = 0; i < top_n; ++i) {
+    const CheckProfile& entry = *rules[i];
+    report << entry.line_num << ":" << entry.column << ": "
+           << entry.seconds * 1000 << " ms, " << entry.lines_probed
+           << " lines probed, " << entry.match_attempts
+           << " match attempts, " << entry.regex_matches
+           << " regex runs: " << entry.rule << "\n";
+  }
+  return report.str();
+}
+
+}  // namespace effcee
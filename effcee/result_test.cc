@@ -31,7 +31,7 @@ using Status = effcee::Result::Status;
 
 // Returns a vector of all failure status values.
 std::vector<Status> AllFailStatusValues() {
-  return {Status::NoRules, Status::BadRule};
+  return {Status::NoRules, Status::BadRule, Status::BadFile};
 }
 
 // Returns a vector of all status values.
@@ -127,4 +127,55 @@ TEST(ResultMessage, SetMessageTwiceRetainsLastMessage) {
   EXPECT_THAT(result.message(), Eq("bar baz"));
 }
 
+// Test failure descriptions.
+
+Result::Failure SampleFailure() {
+  Result::Failure failure;
+  failure.check_index = 2;
+  failure.input_name = "in";
+  failure.checks_name = "checks";
+  failure.notes.push_back({Result::Note::Source::Checks, 9, 2, 8,
+                           "CHECK: foo\n", "error: not found"});
+  failure.notes.push_back({Result::Note::Source::Input, 4, 1, 5,
+                           "abc def\n", "note: scanning from here"});
+  return failure;
+}
+
+TEST(ResultFailure, FailureIsNullWithoutDescription) {
+  Result result(Status::Fail, "oops");
+  EXPECT_THAT(result.failure(), Eq(nullptr));
+}
+
+TEST(ResultFailure, FailureKeepsDescription) {
+  Result result(Status::Fail, SampleFailure());
+  ASSERT_THAT(result.failure(), Not(Eq(nullptr)));
+  EXPECT_THAT(result.failure()->check_index, Eq(2u));
+  EXPECT_THAT(result.failure()->notes.size(), Eq(2u));
+  EXPECT_THAT(result.failure()->notes[1].offset, Eq(4u));
+}
+
+TEST(ResultFailure, MessageIsRenderedFromNotes) {
+  Result result(Status::Fail, SampleFailure());
+  EXPECT_THAT(result.message(),
+              Eq("checks:2:8: error: not found\n"
+                 "CHECK: foo\n"
+                 "       ^\n"
+                 "in:1:5: note: scanning from here\n"
+                 "abc def\n"
+                 "    ^\n"));
+}
+
+TEST(ResultFailure, CopiesShareRenderedMessage) {
+  Result result(Status::Fail, SampleFailure());
+  Result copy(result);
+  EXPECT_THAT(&copy.message(), Eq(&result.message()));
+}
+
+TEST(ResultFailure, SetMessageReplacesRenderedMessage) {
+  Result result(Status::Fail, SampleFailure());
+  result.SetMessage("foo");
+  EXPECT_THAT(result.message(), Eq("foo"));
+  EXPECT_THAT(result.failure(), Not(Eq(nullptr)));
+}
+
 }  // namespace
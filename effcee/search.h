@@ -0,0 +1,125 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_SEARCH_H
+#define EFFCEE_SEARCH_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "re2/stringpiece.h"
+
+namespace effcee {
+
+using StringPiece = re2::StringPiece;
+
+// Returns the offset of the first occurrence of |needle| in |haystack|, or
+// StringPiece::npos if there is none.  An empty needle is found at offset 0.
+// This leans on memchr, which the C library implements with vector
+// instructions suited to the host processor.
+inline size_t FindLiteral(StringPiece haystack, StringPiece needle) {
+  if (needle.empty()) return 0;
+  if (needle.size() > haystack.size()) return StringPiece::npos;
+  const char* const begin = haystack.data();
+  // The last position where the needle could start.
+  const char* const last = begin + (haystack.size() - needle.size());
+  const char first = needle[0];
+  for (const char* p = begin; p <= last; ++p) {
+    p = static_cast<const char*>(std::memchr(p, first, size_t(last - p) + 1));
+    if (p == nullptr) break;
+    if (std::memcmp(p + 1, needle.data() + 1, needle.size() - 1) == 0) {
+      return size_t(p - begin);
+    }
+  }
+  return StringPiece::npos;
+}
+
+// Returns the offset of the last occurrence of |c| in |haystack|, or
+// StringPiece::npos if there is none.  (StringPiece::rfind(char) is broken
+// in some versions of RE2.)
+inline size_t FindLastChar(StringPiece haystack, char c) {
+  for (size_t i = haystack.size(); i > 0; --i) {
+    if (haystack[i - 1] == c) return i - 1;
+  }
+  return StringPiece::npos;
+}
+
+// Returns true if every byte in |text| is a 7-bit ASCII character.
+inline bool IsAscii(StringPiece text) {
+  for (const char c : text) {
+    if (static_cast<unsigned char>(c) & 0x80) return false;
+  }
+  return true;
+}
+
+// A set of non-empty literal strings, found together in one pass over a
+// text.  When the literals all start with the same byte, as rule prefixes
+// such as "CHECK" and "CHECK-O2" usually do, the pass leans on memchr.
+// Otherwise it consults a table of the bytes that start a literal.
+class LiteralSet {
+ public:
+  // Makes a set of the given literals, which must outlive this object.
+  explicit LiteralSet(const std::vector<std::string>& literals)
+      : literals_(literals), first_byte_(), same_first_(true) {
+    for (const auto& literal : literals_) {
+      first_byte_[static_cast<unsigned char>(literal[0])] = true;
+      same_first_ = same_first_ && literal[0] == literals_[0][0];
+    }
+  }
+
+  const std::vector<std::string>& literals() const { return literals_; }
+
+  // Returns true if literal |i| occurs in |haystack| at offset |pos|.
+  bool MatchesAt(StringPiece haystack, size_t pos, size_t i) const {
+    const std::string& literal = literals_[i];
+    return pos + literal.size() <= haystack.size() &&
+           std::memcmp(haystack.data() + pos, literal.data(),
+                       literal.size()) == 0;
+  }
+
+  // Returns the offset of the first position in |haystack| where one of the
+  // literals occurs, or StringPiece::npos if there is none.
+  size_t Find(StringPiece haystack) const {
+    if (literals_.size() == 1) return FindLiteral(haystack, literals_[0]);
+    const char* const begin = haystack.data();
+    const char* const end = begin + haystack.size();
+    for (const char* p = begin; p < end; ++p) {
+      if (same_first_) {
+        p = static_cast<const char*>(
+            std::memchr(p, literals_[0][0], size_t(end - p)));
+        if (p == nullptr) break;
+      } else if (!first_byte_[static_cast<unsigned char>(*p)]) {
+        continue;
+      }
+      for (size_t i = 0; i < literals_.size(); ++i) {
+        if (MatchesAt(haystack, size_t(p - begin), i)) {
+          return size_t(p - begin);
+        }
+      }
+    }
+    return StringPiece::npos;
+  }
+
+ private:
+  const std::vector<std::string>& literals_;
+  // Entry |b| is true if some literal starts with byte |b|.
+  bool first_byte_[256];
+  // True if all the literals start with the same byte.
+  bool same_first_;
+};
+
+}  // namespace effcee
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EFFCEE_STATS_H
+#define EFFCEE_STATS_H
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "effcee.h"
+
+namespace effcee {
+
+using StatsClock = std::chrono::steady_clock;
+
+// Returns the seconds elapsed since |start|.
+inline double SecondsSince(StatsClock::time_point start) {
+  return std::chrono::duration<double>(StatsClock::now() - start).count();
+}
+
+// Adds the time from its construction to its destruction to a number of
+// seconds.  Does nothing if that is null, so statistics cost little when
+// they are not collected.
+class StatsTimer {
+ public:
+  explicit StatsTimer(double* seconds) : seconds_(seconds) {
+    if (seconds_) start_ = StatsClock::now();
+  }
+  ~StatsTimer() {
+    if (seconds_) *seconds_ += SecondsSince(start_);
+  }
+
+  StatsTimer(const StatsTimer&) = delete;
+  StatsTimer& operator=(const StatsTimer&) = delete;
+
+ private:
+  double* seconds_;
+  StatsClock::time_point start_;
+};
+
+// Records a trace event for the time from its construction to its
+// destruction, in a sink.  Does nothing if the sink is null.
+class TraceSpan {
+ public:
+  TraceSpan(TraceEventSink* sink, const char* name, const char* category)
+      : sink_(sink) {
+    if (!sink_) return;
+    event_.name = name;
+    event_.category = category;
+    event_.start = StatsClock::now();
+  }
+  ~TraceSpan() {
+    if (!sink_) return;
+    event_.end = StatsClock::now();
+    sink_->Record(std::move(event_));
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  // Adds a detail to the event.
+  void AddArg(const char* name, std::string value) {
+    if (sink_) event_.args.emplace_back(name, std::move(value));
+  }
+
+ private:
+  TraceEventSink* sink_;
+  TraceEvent event_;
+};
+
+// Records a trace event in |sink| for the time from |start| until now.
+inline void RecordSpan(
+    TraceEventSink* sink, const char* name, const char* category,
+    StatsClock::time_point start,
+    std::vector<std::pair<std::string, std::string>> args) {
+  sink->Record({name, category, start, StatsClock::now(), std::move(args)});
+}
+
+}  // namespace effcee
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "effcee.h"
+
+namespace {
+
+using effcee::Options;
+using effcee::Program;
+using effcee::Result;
+using effcee::StreamingMatcher;
+using ::testing::Combine;
+using ::testing::Eq;
+using ::testing::Range;
+using ::testing::ValuesIn;
+
+using Status = effcee::Result::Status;
+
+// Returns the result of feeding |input| to a streaming matcher for
+// |program|, in chunks of |chunk_size| bytes.  Each chunk is copied to
+// temporary storage, so the matcher can't rely on the chunks staying valid.
+Result FeedInChunks(const Program& program, const std::string& input,
+                    size_t chunk_size) {
+  StreamingMatcher matcher(program);
+  for (size_t start = 0; start < input.size(); start += chunk_size) {
+    std::string chunk = input.substr(start, chunk_size);
+    matcher.Feed(chunk);
+    chunk.assign(chunk.size(), '#');
+  }
+  return matcher.Finish();
+}
+
+// StreamingMatcher class
+
+TEST(StreamingMatcher, EmptyInputPasses) {
+  StreamingMatcher matcher(Program("CHECK-NOT: foo"));
+  EXPECT_TRUE(matcher.Finish());
+}
+
+TEST(StreamingMatcher, EmptyInputFails) {
+  StreamingMatcher matcher(Program("CHECK: foo"));
+  EXPECT_FALSE(matcher.Finish());
+}
+
+TEST(StreamingMatcher, InvalidProgramReturnsCompileResult) {
+  StreamingMatcher matcher(Program("no rules"));
+  EXPECT_FALSE(matcher.Feed("foo\n"));
+  EXPECT_THAT(matcher.Finish().status(), Eq(Status::NoRules));
+}
+
+TEST(StreamingMatcher, FeedReturnsFalseOnceNotCheckMatches) {
+  StreamingMatcher matcher(Program("CHECK: a\nCHECK-NOT: b\nCHECK: c"));
+  EXPECT_TRUE(matcher.Feed("a\n"));
+  EXPECT_FALSE(matcher.Feed("b\n"));
+  EXPECT_FALSE(matcher.Feed("c\n"));
+  EXPECT_THAT(matcher.Finish().status(), Eq(Status::Fail));
+}
+
+TEST(StreamingMatcher, CollectsStatsLikeMatch) {
+  const Program program("CHECK: [[X:a+]]\nCHECK-NOT: b\nCHECK: [[X]]c",
+                        Options().SetCollectStats(true));
+  const std::string input = "aa\nx\naac\n";
+  const auto expected = program.Match(input);
+  const auto actual = FeedInChunks(program, input, 2);
+  ASSERT_THAT(actual.stats(), ::testing::Ne(nullptr));
+  EXPECT_THAT(actual.stats()->lines_scanned,
+              Eq(expected.stats()->lines_scanned));
+  EXPECT_THAT(actual.stats()->bytes_scanned,
+              Eq(expected.stats()->bytes_scanned));
+  EXPECT_THAT(actual.stats()->var_definitions, Eq(1u));
+}
+
+TEST(StreamingMatcher, FeedReturnsFalseOnceAllChecksPass) {
+  StreamingMatcher matcher(Program("CHECK: a\nCHECK: b"));
+  EXPECT_TRUE(matcher.Feed("a\n"));
+  EXPECT_FALSE(matcher.Feed("b\nc\n"));
+  EXPECT_TRUE(matcher.Finish());
+}
+
+TEST(StreamingMatcher, LinesSplitAcrossChunksAreMatchedWhole) {
+  StreamingMatcher matcher(Program("CHECK: Hello World\nCHECK-NEXT: Bye"));
+  EXPECT_TRUE(matcher.Feed("He"));
+  EXPECT_TRUE(matcher.Feed("llo Wor"));
+  EXPECT_TRUE(matcher.Feed("ld\nBy"));
+  EXPECT_TRUE(matcher.Feed("e"));
+  EXPECT_TRUE(matcher.Finish());
+}
+
+// Feeding the input in chunks of any size has the same result as matching
+// it all at once.
+
+struct StreamCase {
+  std::string input;
+  std::string checks;
+};
+
+using StreamingMatcherChunkTest =
+    ::testing::TestWithParam<std::tuple<StreamCase, int>>;
+
+TEST_P(StreamingMatcherChunkTest, SameResultAsMatch) {
+  const auto& stream_case = std::get<0>(GetParam());
+  const size_t chunk_size = size_t(std::get<1>(GetParam()));
+  const Program program(stream_case.checks,
+                        Options().SetInputName("in").SetChecksName("checks"));
+  const Result expected = program.Match(stream_case.input);
+  const Result result = FeedInChunks(program, stream_case.input, chunk_size);
+  EXPECT_THAT(result.status(), Eq(expected.status()));
+  EXPECT_THAT(result.message(), Eq(expected.message()));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllCases, StreamingMatcherChunkTest,
+    Combine(ValuesIn(std::vector<StreamCase>{
+                {"a\nb\nc\n", "CHECK: a\nCHECK: b\nCHECK: c"},
+                {"a\nb\nc", "CHECK: a\nCHECK-NEXT: b\nCHECK-NEXT: c"},
+                {"a\nb\nc\n", "CHECK: a\nCHECK: x"},
+                {"a\nb\nc\n", "CHECK: b\nCHECK-NOT: c"},
+                {"a b\nx\ny\nc\n", "CHECK: a\nCHECK-NEXT: c"},
+                {"a b\nx\ny\nc\n", "CHECK: a\nCHECK-SAME: c"},
+                {"a b\nx\nb a\nc\n", "CHECK-DAG: b\nCHECK-DAG: z\nCHECK: c"},
+                {"x=1\n\n\nx=2\n", "CHECK: x=[[X:[0-9]]]\nCHECK: x=[[X]]"},
+                {"x=12\ny=3\nx=12 y=3\n",
+                 "CHECK: x=[[X:[0-9]+]]\nCHECK: y=[[Y:[0-9]+]]\n"
+                 "CHECK: x=[[X]] y=[[Y]]"},
+                {"x=1\n\n\nx=2\n",
+                 "CHECK: x=[[X:[0-9]]]\nCHECK-NEXT: x={{[0-9]}}"},
+                {"a\nb x\nc\nd\n", "CHECK: a\nCHECK-NOT: x\nCHECK: d"},
+                {"a\nb\nc x\n", "CHECK: a\nCHECK-NOT: y\nCHECK-NOT: x"},
+                {"bar a\n12 bazab\nbaz\n",
+                 "CHECK-NOT: x1\nCHECK-DAG: {{[^z]*}}\nCHECK-NOT: bazab\n"
+                 "CHECK-LABEL: [[W]]"},
+                {"", "CHECK: a"},
+                {"no newline", "CHECK: line"},
+                // Matches that consume the newline ending a line, so that
+                // the line goes on across a chunk boundary.
+                {"a\nb\nc\n", "CHECK: a{{\\s}}\nCHECK-NEXT: c"},
+                {"a\nb\nc\n", "CHECK: a{{\\s}}\nCHECK-NEXT: b"},
+                {"a\nb\nc\n", "CHECK: a{{\\n}}\nCHECK-SAME: b"},
+                {"a\nb\nc\n", "CHECK: a[^x]\nCHECK-SAME: x"},
+                {"a\nb\nc\n", "CHECK: [[V:a\\s]]\nCHECK-NEXT: [[V]]"},
+                {"a\nb\nc\n", "CHECK: a{{\\s}}\nCHECK: b$\nCHECK-SAME: x"},
+                {"a\nb\nc\n",
+                 "CHECK: a{{\\s}}\nCHECK: {{\\B}}\nCHECK-NEXT: x"},
+                {"b bar\n", "CHECK: {{\\n}}\nCHECK: {{x*}}\nCHECK-SAME: z"},
+            }),
+            Range(1, 12)));
+
+}  // namespace
@@ -0,0 +1,125 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "effcee.h"
+#include "make_unique.h"
+
+namespace {
+
+// Returns |text| as a JSON string, with quotes.
+std::string JsonString(const std::string& text) {
+  std::string json("\"");
+  for (const char c : text) {
+    switch (c) {
+      case '"':
+        json += "\\\"";
+        break;
+      case '\\':
+        json += "\\\\";
+        break;
+      case '\n':
+        json += "\\n";
+        break;
+      case '\t':
+        json += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escape[8];
+          std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+          json += escape;
+        } else {
+          json += c;
+        }
+    }
+  }
+  json += "\"";
+  return json;
+}
+
+}  // namespace
+
+namespace effcee {
+
+class ChromeTraceSink::Impl {
+ public:
+  Impl() : origin(std::chrono::steady_clock::now()) {}
+
+  // The time events are measured from.
+  const std::chrono::steady_clock::time_point origin;
+  // Guards the members below.
+  std::mutex mutex;
+  // The events, and the index of the thread that recorded each one.
+  std::vector<std::pair<TraceEvent, size_t>> events;
+  // The threads that recorded events, in order of their first event.
+  std::vector<std::thread::id> threads;
+};
+
+ChromeTraceSink::ChromeTraceSink() : impl_(effcee::make_unique<Impl>()) {}
+
+ChromeTraceSink::~ChromeTraceSink() = default;
+
+void ChromeTraceSink::Record(TraceEvent event) {
+  const auto thread = std::this_thread::get_id();
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  auto& threads = impl_->threads;
+  const auto found = std::find(threads.begin(), threads.end(), thread);
+  const size_t thread_index = size_t(found - threads.begin());
+  if (found == threads.end()) threads.push_back(thread);
+  impl_->events.emplace_back(std::move(event), thread_index);
+}
+
+std::string ChromeTraceSink::ToJson() const {
+  using Micros = std::chrono::duration<double, std::micro>;
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  const auto& events = impl_->events;
+  std::ostringstream json;
+  json << "{\"traceEvents\":[";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const TraceEvent& event = events[i].first;
+    json << (i ? ",\n" : "\n") << "{\"name\":" << JsonString(event.name)
+         << ",\"cat\":" << JsonString(event.category)
+         << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << events[i].second + 1
+         << ",\"ts\":" << Micros(event.start - impl_->origin).count()
+         << ",\"dur\":" << Micros(event.end - event.start).count()
+         << ",\"args\":{";
+    for (size_t j = 0; j < event.args.size(); ++j) {
+      json << (j ? "," : "") << JsonString(event.args[j].first) << ":"
+           << JsonString(event.args[j].second);
+    }
+    json << "}}";
+  }
+  json << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return json.str();
+}
+
+bool ChromeTraceSink::WriteFile(StringPiece path) const {
+  std::ofstream out(std::string(path.data(), path.size()));
+  out << ToJson();
+  return bool(out);
+}
+
+}  // namespace effcee
@@ -0,0 +1,243 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "effcee.h"
+
+namespace {
+
+using effcee::ChromeTraceSink;
+using effcee::Options;
+using effcee::Program;
+using effcee::TraceEvent;
+using effcee::TraceEventSink;
+using ::testing::Contains;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+// A sink that keeps the events it records.
+class RecordingSink : public TraceEventSink {
+ public:
+  void Record(TraceEvent event) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events.push_back(std::move(event));
+  }
+
+  // Returns the recorded events with the given name.
+  std::vector<TraceEvent> Named(const std::string& name) const {
+    std::vector<TraceEvent> result;
+    for (const auto& event : events) {
+      if (event.name == name) result.push_back(event);
+    }
+    return result;
+  }
+
+  std::vector<TraceEvent> events;
+
+ private:
+  std::mutex mutex_;
+};
+
+// Returns an event with the given name and arguments, lasting |micros|
+// microseconds from the given start.
+TraceEvent MakeEvent(const std::string& name,
+                     std::chrono::steady_clock::time_point start, int micros) {
+  return {name, "match", start, start + std::chrono::microseconds(micros), {}};
+}
+
+// Options
+
+TEST(TraceEvent, NoSinkByDefault) {
+  EXPECT_THAT(Options().trace_event_sink(), Eq(nullptr));
+}
+
+TEST(TraceEvent, SetTraceEventSinkReturnsSelf) {
+  Options options;
+  const Options& other =
+      options.SetTraceEventSink(std::make_shared<RecordingSink>());
+  EXPECT_THAT(&other, &options);
+}
+
+TEST(TraceEvent, CopiesOfOptionsShareSink) {
+  auto sink = std::make_shared<RecordingSink>();
+  const Options options = Options().SetTraceEventSink(sink);
+  const Options copy(options);
+  EXPECT_THAT(copy.trace_event_sink(), Eq(sink.get()));
+}
+
+// Events made while parsing and matching
+
+TEST(TraceEvent, ParseRecordsSpans) {
+  auto sink = std::make_shared<RecordingSink>();
+  Program program("CHECK: a\nCHECK-DAG: {{b+}}\nCHECK-DAG: {{c+}}\n",
+                  Options().SetChecksName("in.checks").SetTraceEventSink(sink));
+  ASSERT_TRUE(program);
+  const auto parses = sink->Named("ParseChecks");
+  ASSERT_THAT(parses.size(), Eq(1u));
+  EXPECT_THAT(parses[0].category, Eq("parse"));
+  EXPECT_THAT(parses[0].args, ElementsAre(Pair("checks", "in.checks"),
+                                          Pair("rules", "3")));
+  EXPECT_FALSE(parses[0].end < parses[0].start);
+  // The first check is a literal, and does not compile a regex.
+  const auto compiles = sink->Named("CompileRegex");
+  ASSERT_THAT(compiles.size(), Eq(2u));
+  EXPECT_THAT(compiles[0].args,
+              ElementsAre(Pair("line", "2"), Pair("regex", "{{b+}}")));
+  EXPECT_THAT(compiles[1].args,
+              ElementsAre(Pair("line", "3"), Pair("regex", "{{c+}}")));
+  const auto sets = sink->Named("CompileRegexSets");
+  ASSERT_THAT(sets.size(), Eq(1u));
+  EXPECT_THAT(sets[0].args, ElementsAre(Pair("sets", "1")));
+}
+
+TEST(TraceEvent, MatchRecordsSpanForEachResolvedCheck) {
+  auto sink = std::make_shared<RecordingSink>();
+  Program program("CHECK: a\nCHECK-NOT: x\nCHECK: c\n",
+                  Options().SetTraceEventSink(sink));
+  sink->events.clear();
+  ASSERT_TRUE(program.Match("a\nb\nc\n"));
+
+  const auto checks = sink->Named("Check");
+  ASSERT_THAT(checks.size(), Eq(2u));
+  EXPECT_THAT(checks[0].args,
+              ElementsAre(Pair("check_line", "1"), Pair("rule", "CHECK: a"),
+                          Pair("input_lines", "1-1")));
+  EXPECT_THAT(checks[1].args,
+              ElementsAre(Pair("check_line", "3"), Pair("rule", "CHECK: c"),
+                          Pair("input_lines", "1-3")));
+
+  const auto windows = sink->Named("Window");
+  ASSERT_THAT(windows.size(), Eq(1u));
+  EXPECT_THAT(windows[0].args, ElementsAre(Pair("check_lines", "2-2"),
+                                           Pair("input_lines", "1-3")));
+
+  const auto matches = sink->Named("Match");
+  ASSERT_THAT(matches.size(), Eq(1u));
+  EXPECT_THAT(matches[0].args,
+              ElementsAre(Pair("input", "<stdin>"), Pair("result", "pass")));
+  EXPECT_THAT(sink->Named("Diagnostic"), IsEmpty());
+}
+
+TEST(TraceEvent, FailedMatchRecordsDiagnostic) {
+  auto sink = std::make_shared<RecordingSink>();
+  Program program("CHECK: a\nCHECK-DAG: b\nCHECK-DAG: z\n",
+                  Options().SetTraceEventSink(sink));
+  sink->events.clear();
+  ASSERT_FALSE(program.Match("a\nb\nc\n"));
+
+  const auto diagnostics = sink->Named("Diagnostic");
+  ASSERT_THAT(diagnostics.size(), Eq(1u));
+  EXPECT_THAT(diagnostics[0].args, ElementsAre(Pair("check_line", "3"),
+                                               Pair("rule", "CHECK-DAG: z")));
+  // The window of DAG checks is closed when the match fails.
+  EXPECT_THAT(sink->Named("Window").size(), Eq(1u));
+  const auto matches = sink->Named("Match");
+  ASSERT_THAT(matches.size(), Eq(1u));
+  EXPECT_THAT(matches[0].args, Contains(Pair("result", "fail")));
+}
+
+TEST(TraceEvent, StreamingMatchRecordsSpans) {
+  auto sink = std::make_shared<RecordingSink>();
+  Program program("CHECK: a\nCHECK: c\n", Options().SetTraceEventSink(sink));
+  sink->events.clear();
+  effcee::StreamingMatcher matcher(program);
+  matcher.Feed("a\nb");
+  matcher.Feed("\nc\n");
+  ASSERT_TRUE(matcher.Finish());
+  EXPECT_THAT(sink->Named("Check").size(), Eq(2u));
+  EXPECT_THAT(sink->Named("Match").size(), Eq(1u));
+}
+
+// ChromeTraceSink
+
+TEST(ChromeTraceSink, EmptyTrace) {
+  EXPECT_THAT(ChromeTraceSink().ToJson(),
+              Eq("{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n"));
+}
+
+TEST(ChromeTraceSink, WritesCompleteEvents) {
+  ChromeTraceSink sink;
+  TraceEvent event = MakeEvent("Check", std::chrono::steady_clock::now(), 5);
+  event.args = {{"rule", "CHECK: \"a\"\\b\n"}};
+  sink.Record(event);
+  const std::string json = sink.ToJson();
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"Check\",\"cat\":\"match\","
+                              "\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"));
+  EXPECT_THAT(json, HasSubstr(",\"dur\":5,"));
+  EXPECT_THAT(json,
+              HasSubstr("\"args\":{\"rule\":\"CHECK: \\\"a\\\"\\\\b\\n\"}}"));
+}
+
+TEST(ChromeTraceSink, NumbersThreadsInOrderOfFirstEvent) {
+  ChromeTraceSink sink;
+  const auto start = std::chrono::steady_clock::now();
+  sink.Record(MakeEvent("main", start, 1));
+  std::thread([&]() { sink.Record(MakeEvent("other", start, 1)); }).join();
+  sink.Record(MakeEvent("main", start, 1));
+  const std::string json = sink.ToJson();
+  EXPECT_THAT(json, HasSubstr("\"name\":\"main\",\"cat\":\"match\","
+                              "\"ph\":\"X\",\"pid\":1,\"tid\":1,"));
+  EXPECT_THAT(json, HasSubstr("\"name\":\"other\",\"cat\":\"match\","
+                              "\"ph\":\"X\",\"pid\":1,\"tid\":2,"));
+}
+
+TEST(ChromeTraceSink, CollectsEventsOfBatchMatch) {
+  auto sink = std::make_shared<ChromeTraceSink>();
+  Program program("CHECK: a", Options().SetTraceEventSink(sink));
+  const std::vector<effcee::StringPiece> inputs(8, "a");
+  for (const auto& result : effcee::MatchBatch(program, inputs, 4)) {
+    EXPECT_TRUE(result);
+  }
+  const std::string json = sink->ToJson();
+  size_t num_matches = 0;
+  for (size_t pos = 0;
+       (pos = json.find("\"name\":\"Match\"", pos)) != std::string::npos;
+       ++pos) {
+    ++num_matches;
+  }
+  EXPECT_THAT(num_matches, Eq(8u));
+}
+
+TEST(ChromeTraceSink, WriteFile) {
+  ChromeTraceSink sink;
+  sink.Record(MakeEvent("Check", std::chrono::steady_clock::now(), 1));
+  const std::string path = ::testing::TempDir() + "trace.json";
+  ASSERT_TRUE(sink.WriteFile(path));
+  std::ifstream in(path);
+  const std::string contents((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  EXPECT_THAT(contents, Eq(sink.ToJson()));
+  std::remove(path.c_str());
+}
+
+TEST(ChromeTraceSink, WriteFileFailsForBadPath) {
+  EXPECT_FALSE(ChromeTraceSink().WriteFile(::testing::TempDir() +
+                                           "no-such-dir/trace.json"));
+}
+
+}  // namespace
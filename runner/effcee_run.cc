@@ -0,0 +1,358 @@
+// Copyright 2026 The Effcee Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "effcee/effcee.h"
+
+// Runs many match cases in one process, spread over several threads.
+//
+// A case is a pair of files: an input, and the check rules to match against
+// it.  Cases are found in directories, where NAME.input is paired with
+// NAME.checks, or are listed in a manifest file.  Each line of a manifest
+// names an input file and a checks file, separated by whitespace.  Relative
+// paths in a manifest are relative to the manifest's directory.  Blank lines
+// and lines starting with '#' are ignored.
+//
+// Example:
+//    effcee-run --jobs=8 --timings=timings.txt --shard=0/4 tests/
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char kUsage[] =
+    R"(Usage: effcee-run [options] <directory or manifest>...
+
+Matches each input file against its check rules file, and reports the
+failures.
+
+Options:
+  --jobs=N          Run N cases at a time.  The default is the number of
+                    processors.
+  --shard=I/N       Run only the I'th of N shards of the cases, counting
+                    from 0.
+  --timings=FILE    Read the durations of earlier runs from FILE, and run the
+                    slowest cases first.  Then write this run's durations
+                    to FILE.
+  --prefix=PREFIX   Use PREFIX as the check rule prefix.  The default is
+                    CHECK.
+  --prefixes=P1,P2  Recognize rules with any of the comma-separated prefixes.
+  --regex-max-mem=BYTES
+                    Limit the memory RE2 may use for the regex of each check
+                    rule.  A rule needing more fails its case.
+  --scan-budget=BYTES
+                    Fail a case once its checks have been tried against
+                    BYTES bytes of input, counting a byte again for each
+                    check tried against it.
+  --timeout=SECONDS Stop a case that runs longer than SECONDS, and count it
+                    as failed.
+  --profile=N       Report the N check rules of each case that took the
+                    longest to match.
+  --trace-events=FILE
+                    Write a timeline of the parses and matches to FILE, in
+                    the Chrome trace-event format.
+  --verbose         Report passing cases too.
+)";
+
+// A match case.
+struct Case {
+  // The name used in reports, and to look up timings.
+  std::string name;
+  std::string input_path;
+  std::string checks_path;
+};
+
+// The outcome of running a case.
+struct Outcome {
+  effcee::Result result = effcee::Result(effcee::Result::Status::Ok);
+  double seconds = 0;
+};
+
+// Adds the cases in directory |dir| to |cases|.  Searches subdirectories
+// too.  Returns false if a directory can't be read.
+bool FindCases(const fs::path& dir, std::vector<Case>* cases) {
+  std::error_code error;
+  fs::recursive_directory_iterator it(dir, error);
+  // The directory being read.  Moving on from a directory enters it.
+  fs::path where = dir;
+  for (; !error && it != fs::recursive_directory_iterator();
+       it.increment(error)) {
+    const fs::directory_entry& entry = *it;
+    std::error_code ignored;
+    where = entry.is_directory(ignored) ? entry.path()
+                                        : entry.path().parent_path();
+    if (!entry.is_regular_file(ignored) ||
+        entry.path().extension() != ".checks") {
+      continue;
+    }
+    fs::path input = entry.path();
+    input.replace_extension(".input");
+    if (!fs::exists(input, ignored)) continue;
+    fs::path name = entry.path().lexically_relative(dir);
+    name.replace_extension();
+    cases->push_back(
+        {(dir / name).generic_string(), input.string(), entry.path().string()});
+  }
+  if (error) {
+    std::cerr << "error: cannot read directory " << where.string() << ": "
+              << error.message() << "\n";
+    return false;
+  }
+  return true;
+}
+
+// Adds the cases listed in |manifest| to |cases|.  Returns false if the
+// manifest can't be read or is malformed.
+bool ReadManifest(const fs::path& manifest, std::vector<Case>* cases) {
+  std::ifstream in(manifest);
+  if (!in) {
+    std::cerr << "error: cannot read manifest " << manifest.string() << "\n";
+    return false;
+  }
+  const fs::path base = manifest.parent_path();
+  std::string line;
+  for (int line_num = 1; std::getline(in, line); ++line_num) {
+    std::istringstream fields(line);
+    std::string input, checks, extra;
+    if (!(fields >> input) || input[0] == '#') continue;
+    if (!(fields >> checks) || (fields >> extra)) {
+      std::cerr << manifest.string() << ":" << line_num
+                << ": error: expected an input file and a checks file\n";
+      return false;
+    }
+    const fs::path input_path = base / input;
+    fs::path name = input_path;
+    if (name.extension() == ".input") name.replace_extension();
+    cases->push_back(
+        {name.generic_string(), input_path.string(), (base / checks).string()});
+  }
+  return true;
+}
+
+// Reads the durations in seconds of earlier runs of cases, by case name.
+// A missing file has no durations.
+std::map<std::string, double> ReadTimings(const std::string& path) {
+  std::map<std::string, double> timings;
+  std::ifstream in(path);
+  double seconds;
+  std::string name;
+  while (in >> seconds && std::getline(in >> std::ws, name)) {
+    timings[name] = seconds;
+  }
+  return timings;
+}
+
+// Writes the durations of the cases that ran to |path|.
+void WriteTimings(const std::string& path,
+                  const std::map<std::string, double>& timings) {
+  std::ofstream out(path);
+  out << std::fixed << std::setprecision(6);
+  for (const auto& timing : timings) {
+    out << timing.second << " " << timing.first << "\n";
+  }
+  if (!out) std::cerr << "warning: cannot write timings to " << path << "\n";
+}
+
+// Parses |arg| if it starts with |flag|.  Returns true and sets |value| to
+// the rest of the argument if so.
+bool ParseFlag(const std::string& arg, const char* flag, std::string* value) {
+  const std::string prefix(flag);
+  if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  unsigned num_jobs = std::thread::hardware_concurrency();
+  size_t shard_index = 0;
+  size_t num_shards = 1;
+  std::string timings_path;
+  effcee::Options options;
+  bool verbose = false;
+  size_t profile_top_n = 0;
+  double timeout_seconds = 0;
+  std::shared_ptr<effcee::ChromeTraceSink> trace_sink;
+  std::string trace_path;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    std::string value;
+    if (arg == "--help" || arg == "-h") {
+      std::cout << kUsage;
+      return 0;
+    } else if (ParseFlag(arg, "--jobs=", &value)) {
+      num_jobs = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+    } else if (ParseFlag(arg, "--shard=", &value)) {
+      char slash = 0;
+      std::istringstream shard(value);
+      if (!(shard >> shard_index >> slash >> num_shards) || slash != '/' ||
+          num_shards == 0 || shard_index >= num_shards) {
+        std::cerr << "error: bad shard: " << value << "\n";
+        return 2;
+      }
+    } else if (ParseFlag(arg, "--timings=", &value)) {
+      timings_path = value;
+    } else if (ParseFlag(arg, "--prefix=", &value)) {
+      options.SetPrefix(value);
+    } else if (ParseFlag(arg, "--prefixes=", &value)) {
+      std::vector<std::string> prefixes;
+      std::istringstream list(value);
+      for (std::string prefix; std::getline(list, prefix, ',');) {
+        prefixes.push_back(prefix);
+      }
+      options.SetPrefixes(prefixes);
+    } else if (ParseFlag(arg, "--regex-max-mem=", &value)) {
+      options.SetRegexMaxMem(std::strtoll(value.c_str(), nullptr, 10));
+    } else if (ParseFlag(arg, "--scan-budget=", &value)) {
+      options.SetScanBudget(size_t(std::strtoull(value.c_str(), nullptr, 10)));
+    } else if (ParseFlag(arg, "--timeout=", &value)) {
+      timeout_seconds = std::strtod(value.c_str(), nullptr);
+    } else if (ParseFlag(arg, "--profile=", &value)) {
+      profile_top_n = size_t(std::strtoul(value.c_str(), nullptr, 10));
+      options.SetProfileChecks(profile_top_n > 0);
+    } else if (ParseFlag(arg, "--trace-events=", &value)) {
+      trace_path = value;
+      trace_sink = std::make_shared<effcee::ChromeTraceSink>();
+      options.SetTraceEventSink(trace_sink);
+    } else if (arg == "--verbose" || arg == "-v") {
+      verbose = true;
+    } else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "error: unknown option: " << arg << "\n" << kUsage;
+      return 2;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  // Find the cases.  Sort them by name so every shard sees the same order.
+  std::vector<Case> all_cases;
+  for (const auto& path : paths) {
+    std::error_code error;
+    if (fs::is_directory(path, error)) {
+      if (!FindCases(path, &all_cases)) return 2;
+    } else if (!ReadManifest(path, &all_cases)) {
+      return 2;
+    }
+  }
+  std::sort(all_cases.begin(), all_cases.end(),
+            [](const Case& a, const Case& b) { return a.name < b.name; });
+  std::vector<Case> cases;
+  for (size_t i = shard_index; i < all_cases.size(); i += num_shards) {
+    cases.push_back(all_cases[i]);
+  }
+
+  // Run the slowest cases first, so a long case doesn't start last and
+  // leave the other threads idle.  Cases without a timing may be slow too,
+  // so they go first.
+  std::map<std::string, double> timings;
+  if (!timings_path.empty()) timings = ReadTimings(timings_path);
+  auto duration = [&timings](const Case& c) {
+    const auto timing = timings.find(c.name);
+    return timing == timings.end() ? HUGE_VAL : timing->second;
+  };
+  std::stable_sort(cases.begin(), cases.end(),
+                   [&duration](const Case& a, const Case& b) {
+                     return duration(a) > duration(b);
+                   });
+
+  // Each worker repeatedly claims the next case.
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  std::vector<Outcome> outcomes(cases.size());
+  std::atomic<size_t> next_case(0);
+  std::mutex report_mutex;
+  auto work = [&]() {
+    for (size_t i = next_case++; i < cases.size(); i = next_case++) {
+      const auto case_start = Clock::now();
+      effcee::Options case_options = options;
+      if (timeout_seconds > 0) {
+        case_options.SetDeadline(
+            case_start + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(timeout_seconds)));
+      }
+      auto result = effcee::MatchFile(cases[i].input_path,
+                                      cases[i].checks_path, case_options);
+      outcomes[i].seconds =
+          std::chrono::duration<double>(Clock::now() - case_start).count();
+      if (!result || verbose || profile_top_n) {
+        std::lock_guard<std::mutex> lock(report_mutex);
+        std::cout << (result ? "PASS: " : "FAIL: ") << cases[i].name << "\n";
+        if (!result) std::cout << result.message() << "\n";
+        if (profile_top_n) {
+          std::cout << "Profile of " << cases[i].checks_path << ":\n"
+                    << result.ProfileReport(profile_top_n);
+        }
+      }
+      outcomes[i].result = std::move(result);
+    }
+  };
+  num_jobs = std::max(1u, std::min(num_jobs, unsigned(cases.size())));
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < num_jobs; ++t) workers.emplace_back(work);
+  work();
+  for (auto& worker : workers) worker.join();
+  const double wall_seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  // Report the totals.
+  size_t num_failed = 0;
+  double total_seconds = 0;
+  size_t slowest = 0;
+  for (size_t i = 0; i < cases.size(); ++i) {
+    if (!outcomes[i].result) ++num_failed;
+    total_seconds += outcomes[i].seconds;
+    if (outcomes[i].seconds > outcomes[slowest].seconds) slowest = i;
+    timings[cases[i].name] = outcomes[i].seconds;
+  }
+  std::cout << std::fixed << std::setprecision(3) << cases.size()
+            << " cases: " << (cases.size() - num_failed) << " passed, "
+            << num_failed << " failed\n"
+            << "Time: " << wall_seconds << "s wall, " << total_seconds
+            << "s matching, on " << num_jobs
+            << (num_jobs == 1 ? " thread\n" : " threads\n");
+  if (!cases.empty()) {
+    std::cout << "Slowest: " << cases[slowest].name << " ("
+              << outcomes[slowest].seconds << "s)\n";
+  }
+  if (!timings_path.empty()) WriteTimings(timings_path, timings);
+  if (trace_sink && !trace_sink->WriteFile(trace_path)) {
+    std::cerr << "warning: cannot write trace events to " << trace_path
+              << "\n";
+  }
+
+  return num_failed ? 1 : 0;
+}